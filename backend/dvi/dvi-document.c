@@ -66,6 +66,9 @@ struct _DviDocument
 	
 	gchar *uri;
 
+	/* Checksums of the pages at load time */
+	gchar **fingerprints;
+
 	/* PDF exporter */
 	gchar		 *exporter_filename;
 	GString 	 *exporter_opts;
@@ -83,6 +86,87 @@ EV_BACKEND_REGISTER_WITH_CODE (DviDocument, dvi_document,
       EV_BACKEND_IMPLEMENT_INTERFACE (EV_TYPE_FILE_EXPORTER, dvi_document_file_exporter_iface_init);
      });
 
+/* The DVI commands of a page go from its bop to the next page. The
+ * pointer to the previous page in the bop is skipped, since it changes
+ * whenever a previous page changes size. Font numbers used by the page
+ * are only meaningful with the font definitions, so they are part of
+ * every fingerprint too.
+ */
+#define DVI_BOP_COUNTERS_LEN 41
+#define DVI_BOP_LEN 45
+
+static gchar **
+dvi_document_compute_fingerprints (DviDocument *dvi_document,
+				   const gchar *filename)
+{
+	DviContext *context = dvi_document->context;
+	DviFontRef *font;
+	GChecksum  *fonts_checksum;
+	gchar      *fonts;
+	gchar      *contents;
+	gsize       length;
+	gchar     **fingerprints;
+	gint        i, j;
+
+	if (!g_file_get_contents (filename, &contents, &length, NULL))
+		return NULL;
+
+	fonts_checksum = g_checksum_new (G_CHECKSUM_SHA1);
+	for (font = context->fonts; font; font = font->next) {
+		g_checksum_update (fonts_checksum, (const guchar *) &font->fontid, sizeof (font->fontid));
+		g_checksum_update (fonts_checksum, (const guchar *) &font->ref->checksum, sizeof (font->ref->checksum));
+		g_checksum_update (fonts_checksum, (const guchar *) &font->ref->scale, sizeof (font->ref->scale));
+		g_checksum_update (fonts_checksum, (const guchar *) &font->ref->design, sizeof (font->ref->design));
+		g_checksum_update (fonts_checksum, (const guchar *) font->ref->fontname, -1);
+	}
+	fonts = g_strdup (g_checksum_get_string (fonts_checksum));
+	g_checksum_free (fonts_checksum);
+
+	fingerprints = g_new0 (gchar *, context->npages + 1);
+	for (i = 0; i < context->npages; i++) {
+		GChecksum *checksum;
+		gsize      start = context->pagemap[i][0];
+		gsize      end = length;
+
+		/* Pages are usually stored in order */
+		if (i + 1 < context->npages && context->pagemap[i + 1][0] > (long) start) {
+			end = context->pagemap[i + 1][0];
+		} else {
+			for (j = 0; j < context->npages; j++) {
+				if (context->pagemap[j][0] > (long) start)
+					end = MIN (end, (gsize) context->pagemap[j][0]);
+			}
+		}
+
+		if (end > length || start + DVI_BOP_LEN > end) {
+			g_strfreev (fingerprints);
+			g_free (contents);
+			g_free (fonts);
+
+			return NULL;
+		}
+
+		checksum = g_checksum_new (G_CHECKSUM_SHA1);
+		g_checksum_update (checksum, (const guchar *) fonts, -1);
+		g_checksum_update (checksum, (const guchar *) &dvi_document->base_width,
+				   sizeof (dvi_document->base_width));
+		g_checksum_update (checksum, (const guchar *) &dvi_document->base_height,
+				   sizeof (dvi_document->base_height));
+		g_checksum_update (checksum, (const guchar *) &context->dvimag,
+				   sizeof (context->dvimag));
+		g_checksum_update (checksum, (const guchar *) contents + start,
+				   DVI_BOP_COUNTERS_LEN);
+		g_checksum_update (checksum, (const guchar *) contents + start + DVI_BOP_LEN,
+				   end - start - DVI_BOP_LEN);
+		fingerprints[i] = g_strdup (g_checksum_get_string (checksum));
+		g_checksum_free (checksum);
+	}
+	g_free (contents);
+	g_free (fonts);
+
+	return fingerprints;
+}
+
 static gboolean
 dvi_document_load (EvDocument  *document,
 		   const char  *uri,
@@ -101,9 +185,9 @@ dvi_document_load (EvDocument  *document,
 
 	dvi_document->context = mdvi_init_context(dvi_document->params, dvi_document->spec, filename);
 	g_mutex_unlock (&dvi_context_mutex);
-	g_free (filename);
 	
 	if (!dvi_document->context) {
+		g_free (filename);
     		g_set_error_literal (error,
                                      EV_DOCUMENT_ERROR,
                                      EV_DOCUMENT_ERROR_INVALID,
@@ -119,6 +203,10 @@ dvi_document_load (EvDocument  *document,
 	
 	dvi_document->base_height = dvi_document->context->dvi_page_h * dvi_document->context->params.vconv 
 	        + 2 * unit2pix(dvi_document->params->vdpi, MDVI_VMARGIN) / dvi_document->params->vshrink;
+
+	g_strfreev (dvi_document->fingerprints);
+	dvi_document->fingerprints = dvi_document_compute_fingerprints (dvi_document, filename);
+	g_free (filename);
 	
 	g_free (dvi_document->uri);
 	dvi_document->uri = g_strdup (uri);
@@ -231,10 +319,23 @@ dvi_document_finalize (GObject *object)
 		g_string_free (dvi_document->exporter_opts, TRUE);
 
         g_free (dvi_document->uri);
+	g_strfreev (dvi_document->fingerprints);
 		
 	G_OBJECT_CLASS (dvi_document_parent_class)->finalize (object);
 }
 
+static gchar *
+dvi_document_get_page_fingerprint (EvDocument *document,
+				   EvPage     *page)
+{
+	DviDocument *dvi_document = DVI_DOCUMENT (document);
+
+	if (!dvi_document->fingerprints)
+		return NULL;
+
+	return g_strdup (dvi_document->fingerprints[page->index]);
+}
+
 static gboolean
 dvi_document_support_synctex (EvDocument *document)
 {
@@ -263,6 +364,7 @@ dvi_document_class_init (DviDocumentClass *klass)
 	ev_document_class->get_page_size = dvi_document_get_page_size;
 	ev_document_class->render = dvi_document_render;
 	ev_document_class->support_synctex = dvi_document_support_synctex;
+	ev_document_class->get_page_fingerprint = dvi_document_get_page_fingerprint;
 }
 
 /* EvFileExporterIface */
@@ -404,10 +404,29 @@ pdf_page_render (PopplerPage     *page,
 	double page_width, page_height;
 	double xscale, yscale;
 
-	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-					      width, height);
+	/* Only rasterize the requested area when there's a region: the
+	 * surface has the size of the region and the page is shifted so
+	 * that the region origin ends up at (0, 0).
+	 */
+	if (rc->has_region)
+		surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+						      rc->region.width,
+						      rc->region.height);
+	else
+		surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+						      width, height);
 	cr = cairo_create (surface);
 
+	/* Pages are always rendered on a white background, so the surface
+	 * is opaque: clear it to white and let poppler draw on top instead
+	 * of compositing the background afterwards.
+	 */
+	cairo_set_source_rgb (cr, 1., 1., 1.);
+	cairo_paint (cr);
+
+	if (rc->has_region)
+		cairo_translate (cr, -rc->region.x, -rc->region.y);
+
 	switch (rc->rotation) {
 	        case 90:
 			cairo_translate (cr, width, 0);
@@ -429,11 +448,6 @@ pdf_page_render (PopplerPage     *page,
 	cairo_scale (cr, xscale, yscale);
 	cairo_rotate (cr, rc->rotation * G_PI / 180.0);
 	poppler_page_render (page, cr);
-
-	cairo_set_operator (cr, CAIRO_OPERATOR_DEST_OVER);
-	cairo_set_source_rgb (cr, 1., 1., 1.);
-	cairo_paint (cr);
-
 	cairo_destroy (cr);
 
 	return surface;
@@ -477,6 +491,23 @@ make_thumbnail_for_page (PopplerPage     *poppler_page,
 	return pixbuf;
 }
 
+/* The embedded thumbnail can be used as long as it's not smaller than
+ * the requested size, downscaling it is a lot cheaper than rendering the
+ * page. Thumbnails not matching the aspect of the page, within a pixel
+ * at the requested size, are ignored since they would be distorted.
+ */
+static gboolean
+embedded_thumbnail_is_usable (gint thumb_width,
+			      gint thumb_height,
+			      gint width,
+			      gint height)
+{
+	if (thumb_width < width || thumb_width <= 0)
+		return FALSE;
+
+	return ABS ((gdouble) thumb_height * width / thumb_width - height) <= 1.;
+}
+
 static GdkPixbuf *
 pdf_document_get_thumbnail (EvDocument      *document,
 			    EvRenderContext *rc)
@@ -486,6 +517,7 @@ pdf_document_get_thumbnail (EvDocument      *document,
 	GdkPixbuf *pixbuf = NULL;
 	double page_width, page_height;
 	gint width, height;
+	gint scaled_width, scaled_height;
 
 	poppler_page = POPPLER_PAGE (rc->page->backend_page);
 
@@ -494,6 +526,8 @@ pdf_document_get_thumbnail (EvDocument      *document,
 
 	ev_render_context_compute_transformed_size (rc, page_width, page_height,
 						    &width, &height);
+	ev_render_context_compute_scaled_size (rc, page_width, page_height,
+					       &scaled_width, &scaled_height);
 
 	surface = poppler_page_get_thumbnail (poppler_page);
 	if (surface) {
@@ -501,25 +535,33 @@ pdf_document_get_thumbnail (EvDocument      *document,
 		cairo_surface_destroy (surface);
 	}
 
-	if (pixbuf != NULL) {
-		int thumb_width = (rc->rotation == 90 || rc->rotation == 270) ?
-			gdk_pixbuf_get_height (pixbuf) :
-			gdk_pixbuf_get_width (pixbuf);
+	if (pixbuf != NULL && !rc->has_region &&
+	    embedded_thumbnail_is_usable (gdk_pixbuf_get_width (pixbuf),
+					  gdk_pixbuf_get_height (pixbuf),
+					  scaled_width, scaled_height)) {
+		GdkPixbuf *rotated_pixbuf;
 
-		if (thumb_width == width) {
-			GdkPixbuf *rotated_pixbuf;
+		if (gdk_pixbuf_get_width (pixbuf) != scaled_width ||
+		    gdk_pixbuf_get_height (pixbuf) != scaled_height) {
+			GdkPixbuf *scaled_pixbuf;
 
-			rotated_pixbuf = gdk_pixbuf_rotate_simple (pixbuf,
-								   (GdkPixbufRotation) (360 - rc->rotation));
-			g_object_unref (pixbuf);
-			pixbuf = rotated_pixbuf;
-		} else {
-			/* The provided thumbnail has a different size */
+			scaled_pixbuf = gdk_pixbuf_scale_simple (pixbuf,
+								 scaled_width,
+								 scaled_height,
+								 GDK_INTERP_BILINEAR);
 			g_object_unref (pixbuf);
-			pixbuf = make_thumbnail_for_page (poppler_page, rc, width, height);
+			pixbuf = scaled_pixbuf;
 		}
+
+		rotated_pixbuf = gdk_pixbuf_rotate_simple (pixbuf,
+							   (GdkPixbufRotation) (360 - rc->rotation));
+		g_object_unref (pixbuf);
+		pixbuf = rotated_pixbuf;
 	} else {
-		/* There is no provided thumbnail. We need to make one. */
+		/* There is no provided thumbnail or it can't be used.
+		 * We need to make one.
+		 */
+		g_clear_object (&pixbuf);
 		pixbuf = make_thumbnail_for_page (poppler_page, rc, width, height);
 	}
 
@@ -535,6 +577,7 @@ pdf_document_get_thumbnail_surface (EvDocument      *document,
 	cairo_surface_t *surface;
 	double page_width, page_height;
 	gint width, height;
+	gint scaled_width, scaled_height;
 
 	poppler_page = POPPLER_PAGE (rc->page->backend_page);
 
@@ -543,21 +586,25 @@ pdf_document_get_thumbnail_surface (EvDocument      *document,
 
 	ev_render_context_compute_transformed_size (rc, page_width, page_height,
 						    &width, &height);
+	ev_render_context_compute_scaled_size (rc, page_width, page_height,
+					       &scaled_width, &scaled_height);
 
 	surface = poppler_page_get_thumbnail (poppler_page);
 	if (surface) {
-		int surface_width = (rc->rotation == 90 || rc->rotation == 270) ?
-			cairo_image_surface_get_height (surface) :
-			cairo_image_surface_get_width (surface);
-
-		if (surface_width == width) {
+		if (!rc->has_region &&
+		    embedded_thumbnail_is_usable (cairo_image_surface_get_width (surface),
+						  cairo_image_surface_get_height (surface),
+						  scaled_width, scaled_height)) {
 			cairo_surface_t *rotated_surface;
 
-			rotated_surface = ev_document_misc_surface_rotate_and_scale (surface, width, height, rc->rotation);
+			rotated_surface = ev_document_misc_surface_rotate_and_scale (surface,
+										     scaled_width,
+										     scaled_height,
+										     rc->rotation);
 			cairo_surface_destroy (surface);
 			return rotated_surface;
 		} else {
-			/* The provided thumbnail has a different size */
+			/* The provided thumbnail can't be used */
 			cairo_surface_destroy (surface);
 		}
 	}
@@ -943,8 +990,8 @@ pdf_document_fonts_get_fonts_summary (EvDocumentFonts *document_fonts)
 }
 
 static void
-pdf_document_fonts_fill_model (EvDocumentFonts *document_fonts,
-			       GtkTreeModel    *model)
+pdf_document_fonts_get_fonts (EvDocumentFonts *document_fonts,
+			      GPtrArray       *fonts)
 {
 	PdfDocument *pdf_document = PDF_DOCUMENT (document_fonts);
 	PopplerFontsIter *iter = pdf_document->fonts_iter;
@@ -955,7 +1002,6 @@ pdf_document_fonts_fill_model (EvDocumentFonts *document_fonts,
 		return;
 
 	do {
-		GtkTreeIter list_iter;
 		const char *name;
 		PopplerFontType type;
 		const char *type_str;
@@ -964,7 +1010,7 @@ pdf_document_fonts_fill_model (EvDocumentFonts *document_fonts,
 		const gchar *substitute;
 		const gchar *filename;
 		const gchar *encoding;
-		char *details;
+		gchar *details;
 
 		name = poppler_fonts_iter_get_name (iter);
 
@@ -1047,20 +1093,39 @@ pdf_document_fonts_fill_model (EvDocumentFonts *document_fonts,
 							   type_str, standard_str,
 							   encoding, embedded);
 
+		g_ptr_array_add (fonts, g_strdup (name));
+		g_ptr_array_add (fonts, details);
+	} while (poppler_fonts_iter_next (iter));
+}
+
+static void
+pdf_document_fonts_fill_model (EvDocumentFonts *document_fonts,
+			       GtkTreeModel    *model)
+{
+	GPtrArray *fonts;
+	guint      i;
+
+	fonts = g_ptr_array_new_with_free_func (g_free);
+	pdf_document_fonts_get_fonts (document_fonts, fonts);
+
+	for (i = 0; i + 1 < fonts->len; i += 2) {
+		GtkTreeIter list_iter;
+
 		gtk_list_store_append (GTK_LIST_STORE (model), &list_iter);
 		gtk_list_store_set (GTK_LIST_STORE (model), &list_iter,
-				    EV_DOCUMENT_FONTS_COLUMN_NAME, name,
-				    EV_DOCUMENT_FONTS_COLUMN_DETAILS, details,
+				    EV_DOCUMENT_FONTS_COLUMN_NAME, g_ptr_array_index (fonts, i),
+				    EV_DOCUMENT_FONTS_COLUMN_DETAILS, g_ptr_array_index (fonts, i + 1),
 				    -1);
+	}
 
-		g_free (details);
-	} while (poppler_fonts_iter_next (iter));
+	g_ptr_array_unref (fonts);
 }
 
 static void
 pdf_document_document_fonts_iface_init (EvDocumentFontsInterface *iface)
 {
 	iface->fill_model = pdf_document_fonts_fill_model;
+	iface->get_fonts = pdf_document_fonts_get_fonts;
 	iface->get_fonts_summary = pdf_document_fonts_get_fonts_summary;
 	iface->scan = pdf_document_fonts_scan;
 	iface->get_progress = pdf_document_fonts_get_progress;
@@ -32,8 +32,9 @@
 struct _PSDocument {
 	EvDocument object;
 
-	SpectreDocument *doc;
-	SpectreExporter *exporter;
+	SpectreDocument      *doc;
+	SpectreExporter      *exporter;
+	SpectreRenderContext *src;
 };
 
 struct _PSDocumentClass {
@@ -69,6 +70,11 @@ ps_document_dispose (GObject *object)
 		ps->exporter = NULL;
 	}
 
+	if (ps->src) {
+		spectre_render_context_free (ps->src);
+		ps->src = NULL;
+	}
+
 	G_OBJECT_CLASS (ps_document_parent_class)->dispose (object);
 }
 
@@ -279,10 +285,25 @@ ps_document_get_backend_info (EvDocument            *document,
 	return TRUE;
 }
 
+/* The render context is kept for the whole life of the document so that
+ * consecutive renders don't have to set up the rendering parameters
+ * again; only scale and rotation change from page to page. Rendering
+ * always happens with the document mutex held, so it's safe to share it.
+ */
+static SpectreRenderContext *
+ps_document_get_render_context (PSDocument *ps)
+{
+	if (!ps->src)
+		ps->src = spectre_render_context_new ();
+
+	return ps->src;
+}
+
 static cairo_surface_t *
 ps_document_render (EvDocument      *document,
 		    EvRenderContext *rc)
 {
+	PSDocument           *ps = PS_DOCUMENT (document);
 	SpectrePage          *ps_page;
 	SpectreRenderContext *src;
 	gint                  width_points;
@@ -312,13 +333,12 @@ ps_document_render (EvDocument      *document,
 		sheight = height;
 	}
 
-	src = spectre_render_context_new ();
+	src = ps_document_get_render_context (ps);
 	spectre_render_context_set_scale (src,
 					  (gdouble)swidth / width_points,
 					  (gdouble)sheight / height_points);
 	spectre_render_context_set_rotation (src, rotation);
 	spectre_page_render (ps_page, src, &data, &stride);
-	spectre_render_context_free (src);
 
 	if (!data) {
 		return NULL;
@@ -24,6 +24,7 @@
 #include <config.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <glib.h>
 #include <glib/gi18n-lib.h>
 
@@ -337,6 +338,62 @@ tiff_document_render (EvDocument      *document,
 	return rotated_surface;
 }
 
+/* Selects the smallest reduced resolution image (SubIFD) of the current
+ * page that is at least min_width pixels wide, so that thumbnails don't
+ * need to decode the full resolution page. If there isn't any, the page
+ * directory is selected again and FALSE is returned.
+ */
+static gboolean
+tiff_document_select_reduced_image (TiffDocument *tiff_document,
+				    gint          page_index,
+				    int           min_width,
+				    int          *width,
+				    int          *height)
+{
+	guint16  n_subifds = 0;
+	toff_t  *subifds = NULL;
+	toff_t  *offsets;
+	toff_t   best_offset = 0;
+	guint32  best_width = 0;
+	guint16  i;
+
+	if (!TIFFGetField (tiff_document->tiff, TIFFTAG_SUBIFD, &n_subifds, &subifds) ||
+	    n_subifds == 0)
+		return FALSE;
+
+	/* The array belongs to the current directory */
+	offsets = g_new (toff_t, n_subifds);
+	memcpy (offsets, subifds, n_subifds * sizeof (toff_t));
+
+	for (i = 0; i < n_subifds; i++) {
+		guint32 w;
+
+		if (TIFFSetSubDirectory (tiff_document->tiff, offsets[i]) != 1)
+			continue;
+
+		if (!TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGEWIDTH, &w))
+			continue;
+
+		if (w >= (guint32) min_width && (best_offset == 0 || w < best_width)) {
+			best_offset = offsets[i];
+			best_width = w;
+		}
+	}
+	g_free (offsets);
+
+	if (best_offset != 0 &&
+	    TIFFSetSubDirectory (tiff_document->tiff, best_offset) == 1 &&
+	    TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGEWIDTH, width) &&
+	    TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGELENGTH, height))
+		return TRUE;
+
+	TIFFSetDirectory (tiff_document->tiff, page_index);
+	TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGEWIDTH, width);
+	TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGELENGTH, height);
+
+	return FALSE;
+}
+
 static GdkPixbuf *
 tiff_document_get_thumbnail (EvDocument      *document,
 			     EvRenderContext *rc)
@@ -368,6 +425,11 @@ tiff_document_get_thumbnail (EvDocument      *document,
 	}
 
 	tiff_document_get_resolution (tiff_document, &x_res, &y_res);
+
+	ev_render_context_compute_scaled_size (rc, width, height * (x_res / y_res),
+					       &scaled_width, &scaled_height);
+	tiff_document_select_reduced_image (tiff_document, rc->page->index,
+					    scaled_width, &width, &height);
 	
 	pop_handlers ();
   
@@ -402,8 +464,6 @@ tiff_document_get_thumbnail (EvDocument      *document,
 					   (GdkPixbufDestroyNotify) g_free, NULL);
 	pop_handlers ();
 
-	ev_render_context_compute_scaled_size (rc, width, height * (x_res / y_res),
-					       &scaled_width, &scaled_height);
 	scaled_pixbuf = gdk_pixbuf_scale_simple (pixbuf,
 						 scaled_width, scaled_height,
 						 GDK_INTERP_BILINEAR);
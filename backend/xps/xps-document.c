@@ -214,7 +214,7 @@ xps_document_render (EvDocument      *document,
 	ev_render_context_compute_transformed_size (rc, page_width, page_height,
                                                     &width, &height);
 
-	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+	surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24,
 					      width, height);
 	cr = cairo_create (surface);
 
@@ -68,3 +68,30 @@ ev_document_fonts_get_fonts_summary (EvDocumentFonts *document_fonts)
 
 	return iface->get_fonts_summary (document_fonts);
 }
+
+/**
+ * ev_document_fonts_get_fonts:
+ * @document_fonts: an #EvDocumentFonts
+ * @fonts: (element-type utf8): a #GPtrArray
+ *
+ * Appends to @fonts newly allocated strings with the name and the
+ * details of every font found by the last scan, one after the other,
+ * like ev_document_fonts_fill_model() does with the rows of a model.
+ * Unlike it, this doesn't create any GTK object, so it can be used
+ * from a thread.
+ *
+ * Since: 43
+ */
+void
+ev_document_fonts_get_fonts (EvDocumentFonts *document_fonts,
+			     GPtrArray       *fonts)
+{
+	EvDocumentFontsInterface *iface = EV_DOCUMENT_FONTS_GET_IFACE (document_fonts);
+
+	g_return_if_fail (fonts != NULL);
+
+	if (!iface->get_fonts)
+		return;
+
+	iface->get_fonts (document_fonts, fonts);
+}
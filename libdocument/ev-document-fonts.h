@@ -65,6 +65,8 @@ struct _EvDocumentFontsInterface
         void         (* fill_model)        (EvDocumentFonts *document_fonts,
                                             GtkTreeModel    *model);
         const gchar *(* get_fonts_summary) (EvDocumentFonts *document_fonts);
+        void         (* get_fonts)         (EvDocumentFonts *document_fonts,
+                                            GPtrArray       *fonts);
 };
 
 EV_PUBLIC
@@ -79,5 +81,8 @@ void         ev_document_fonts_fill_model        (EvDocumentFonts *document_font
                                                   GtkTreeModel    *model);
 EV_PUBLIC
 const gchar *ev_document_fonts_get_fonts_summary (EvDocumentFonts *document_fonts);
+EV_PUBLIC
+void         ev_document_fonts_get_fonts         (EvDocumentFonts *document_fonts,
+                                                  GPtrArray       *fonts);
 
 G_END_DECLS
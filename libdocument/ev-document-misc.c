@@ -462,7 +462,6 @@ ev_document_misc_surface_rotate_and_scale (cairo_surface_t *surface,
 	cairo_rotate (cr, dest_rotation * G_PI / 180.0);
 	
 	if (dest_width != width || dest_height != height) {
-		cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_BILINEAR);
 		cairo_scale (cr,
 			     (gdouble)dest_width / width,
 			     (gdouble)dest_height / height);
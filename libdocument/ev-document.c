@@ -28,6 +28,8 @@
 #include <errno.h>
 
 #include "ev-document.h"
+#include "ev-document-annotations.h"
+#include "ev-document-forms.h"
 #include "ev-document-misc.h"
 #include "synctex_parser.h"
 
@@ -245,6 +247,33 @@ ev_document_set_modified (EvDocument *document,
 	}
 }
 
+/**
+ * ev_document_has_unsaved_changes:
+ * @document: an #EvDocument
+ *
+ * Checks whether forms or annotations of @document were changed since
+ * it was loaded, so that it's no longer the same as its file.
+ *
+ * Returns: %TRUE if @document has changes that its file doesn't have
+ *
+ * Since: 43
+ */
+gboolean
+ev_document_has_unsaved_changes (EvDocument *document)
+{
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
+
+	if (EV_IS_DOCUMENT_FORMS (document) &&
+	    ev_document_forms_document_is_modified (EV_DOCUMENT_FORMS (document)))
+		return TRUE;
+
+	if (EV_IS_DOCUMENT_ANNOTATIONS (document) &&
+	    ev_document_annotations_document_is_modified (EV_DOCUMENT_ANNOTATIONS (document)))
+		return TRUE;
+
+	return FALSE;
+}
+
 void
 ev_document_doc_mutex_lock (void)
 {
@@ -392,6 +421,12 @@ ev_document_initialize_synctex (EvDocument  *document,
  * @error: a #GError location to store an error, or %NULL
  *
  * Loads @document from @uri.
+ *
+ * With %EV_DOCUMENT_LOAD_FLAG_PROBE only what's needed to get the
+ * document info, the number of pages and to render the first page is
+ * loaded: the per-page cache is built lazily on first use and SyncTeX
+ * data is not loaded at all. This is meant for metadata readers and
+ * thumbnailers.
  * 
  * On failure, %FALSE is returned and @error is filled in.
  * If the document is encrypted, EV_DEFINE_ERROR_ENCRYPTED is returned.
@@ -429,11 +464,12 @@ ev_document_load_full (EvDocument           *document,
 	} else {
 		document->priv->info = _ev_document_get_info (document);
 		document->priv->n_pages = _ev_document_get_n_pages (document);
-		if (!(flags & EV_DOCUMENT_LOAD_FLAG_NO_CACHE))
+		if (!(flags & (EV_DOCUMENT_LOAD_FLAG_NO_CACHE | EV_DOCUMENT_LOAD_FLAG_PROBE)))
 			ev_document_setup_cache (document);
 		document->priv->uri = g_strdup (uri);
 		document->priv->file_size = _ev_document_get_size (uri);
-		ev_document_initialize_synctex (document, uri);
+		if (!(flags & EV_DOCUMENT_LOAD_FLAG_PROBE))
+			ev_document_initialize_synctex (document, uri);
         }
 
 	return retval;
@@ -508,7 +544,7 @@ ev_document_load_stream (EvDocument         *document,
 	document->priv->info = _ev_document_get_info (document);
 	document->priv->n_pages = _ev_document_get_n_pages (document);
 
-        if (!(flags & EV_DOCUMENT_LOAD_FLAG_NO_CACHE))
+        if (!(flags & (EV_DOCUMENT_LOAD_FLAG_NO_CACHE | EV_DOCUMENT_LOAD_FLAG_PROBE)))
                 ev_document_setup_cache (document);
 
         return TRUE;
@@ -556,12 +592,13 @@ ev_document_load_gfile (EvDocument         *document,
 	document->priv->info = _ev_document_get_info (document);
 	document->priv->n_pages = _ev_document_get_n_pages (document);
 
-        if (!(flags & EV_DOCUMENT_LOAD_FLAG_NO_CACHE))
+        if (!(flags & (EV_DOCUMENT_LOAD_FLAG_NO_CACHE | EV_DOCUMENT_LOAD_FLAG_PROBE)))
                 ev_document_setup_cache (document);
 
 	document->priv->uri = g_file_get_uri (file);
 	document->priv->file_size = _ev_document_get_size_gfile (file);
-	ev_document_initialize_synctex (document, document->priv->uri);
+	if (!(flags & EV_DOCUMENT_LOAD_FLAG_PROBE))
+		ev_document_initialize_synctex (document, document->priv->uri);
 
         return TRUE;
 }
@@ -646,7 +683,7 @@ ev_document_load_fd (EvDocument         *document,
         document->priv->info = _ev_document_get_info (document);
         document->priv->n_pages = _ev_document_get_n_pages (document);
 
-        if (!(flags & EV_DOCUMENT_LOAD_FLAG_NO_CACHE))
+        if (!(flags & (EV_DOCUMENT_LOAD_FLAG_NO_CACHE | EV_DOCUMENT_LOAD_FLAG_PROBE)))
                 ev_document_setup_cache (document);
 
         return TRUE;
@@ -935,6 +972,47 @@ ev_document_get_page_label (EvDocument *document,
 		g_strdup_printf ("%d", page_index + 1);
 }
 
+/**
+ * ev_document_get_page_fingerprint:
+ * @document: an #EvDocument
+ * @page_index: the page index
+ *
+ * Returns a string identifying the contents of the page as they were
+ * when @document was loaded. When the same file is loaded again, pages
+ * with the same fingerprint in both documents render the same way, so
+ * anything rendered for them can be kept.
+ *
+ * Backends compute the fingerprints when the document is loaded, so
+ * this doesn't take the document lock and is cheap enough to be called
+ * for many pages from the main thread.
+ *
+ * Returns: (transfer full) (nullable): the fingerprint of the page, or
+ *   %NULL if the backend can't tell whether a page changed
+ *
+ * Since: 43
+ */
+gchar *
+ev_document_get_page_fingerprint (EvDocument *document,
+				  gint        page_index)
+{
+	EvDocumentClass *klass;
+	EvPage          *page;
+	gchar           *fingerprint;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
+	g_return_val_if_fail (page_index >= 0 && page_index < document->priv->n_pages, NULL);
+
+	klass = EV_DOCUMENT_GET_CLASS (document);
+	if (!klass->get_page_fingerprint)
+		return NULL;
+
+	page = ev_document_get_page (document, page_index);
+	fingerprint = klass->get_page_fingerprint (document, page);
+	g_object_unref (page);
+
+	return fingerprint;
+}
+
 static EvDocumentInfo *
 _ev_document_get_info (EvDocument *document)
 {
@@ -978,8 +1056,33 @@ ev_document_render (EvDocument      *document,
 		    EvRenderContext *rc)
 {
 	EvDocumentClass *klass = EV_DOCUMENT_GET_CLASS (document);
+	cairo_surface_t *surface;
+	cairo_surface_t *region_surface;
+	cairo_t         *cr;
 
-	return klass->render (document, rc);
+	surface = klass->render (document, rc);
+	if (!surface || !rc->has_region)
+		return surface;
+
+	/* Backends that can't render a region return the whole page,
+	 * crop it here so that callers always get a region sized surface.
+	 */
+	if (cairo_image_surface_get_width (surface) == rc->region.width &&
+	    cairo_image_surface_get_height (surface) == rc->region.height)
+		return surface;
+
+	region_surface = cairo_surface_create_similar_image (surface,
+							     cairo_image_surface_get_format (surface),
+							     rc->region.width,
+							     rc->region.height);
+	cr = cairo_create (region_surface);
+	cairo_set_source_surface (cr, surface, -rc->region.x, -rc->region.y);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+	cairo_surface_destroy (surface);
+
+	return region_surface;
 }
 
 static GdkPixbuf *
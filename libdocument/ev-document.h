@@ -52,8 +52,9 @@ typedef struct _EvDocumentPrivate EvDocumentPrivate;
 #define EV_DOC_MUTEX_UNLOCK (ev_document_doc_mutex_unlock ())
 
 typedef enum /*< flags >*/ {
-        EV_DOCUMENT_LOAD_FLAG_NONE = 0,
-        EV_DOCUMENT_LOAD_FLAG_NO_CACHE
+        EV_DOCUMENT_LOAD_FLAG_NONE     = 0,
+        EV_DOCUMENT_LOAD_FLAG_NO_CACHE = 1 << 0,
+        EV_DOCUMENT_LOAD_FLAG_PROBE    = 1 << 1
 } EvDocumentLoadFlags;
 
 typedef enum
@@ -134,6 +135,8 @@ struct _EvDocumentClass
 						     EvDocumentLoadFlags  flags,
 						     GCancellable        *cancellable,
 						     GError             **error);
+        gchar           * (* get_page_fingerprint)  (EvDocument          *document,
+						     EvPage              *page);
 };
 
 EV_PUBLIC
@@ -168,6 +171,8 @@ EV_PUBLIC
 void             ev_document_set_modified         (EvDocument      *document,
 						   gboolean         modified);
 EV_PUBLIC
+gboolean         ev_document_has_unsaved_changes  (EvDocument      *document);
+EV_PUBLIC
 gboolean         ev_document_load                 (EvDocument      *document,
 						   const char      *uri,
 						   GError         **error);
@@ -212,6 +217,9 @@ EV_PUBLIC
 gchar           *ev_document_get_page_label       (EvDocument      *document,
 						   gint             page_index);
 EV_PUBLIC
+gchar           *ev_document_get_page_fingerprint (EvDocument      *document,
+						   gint             page_index);
+EV_PUBLIC
 cairo_surface_t *ev_document_render               (EvDocument      *document,
 						   EvRenderContext *rc);
 EV_PUBLIC
@@ -113,6 +113,32 @@ ev_render_context_set_target_size (EvRenderContext *rc,
 	rc->target_height = target_height;
 }
 
+/**
+ * ev_render_context_set_region:
+ * @rc: an #EvRenderContext
+ * @region: (nullable): the area of the page to render, or %NULL
+ *
+ * Restricts rendering to @region, given in pixels of the transformed
+ * (scaled and rotated) page. The rendered surface will have the size of
+ * @region instead of the size of the whole page. Passing %NULL renders
+ * the whole page again.
+ *
+ * Since: 43
+ */
+void
+ev_render_context_set_region (EvRenderContext             *rc,
+			      const cairo_rectangle_int_t *region)
+{
+	g_return_if_fail (rc != NULL);
+
+	if (region) {
+		rc->has_region = TRUE;
+		rc->region = *region;
+	} else {
+		rc->has_region = FALSE;
+	}
+}
+
 void
 ev_render_context_compute_scaled_size (EvRenderContext *rc,
 				       double		width_points,
@@ -24,6 +24,7 @@
 #endif
 
 #include <glib-object.h>
+#include <cairo.h>
 
 #include "ev-macros.h"
 #include "ev-page.h"
@@ -52,6 +53,9 @@ struct _EvRenderContext
 	gdouble scale;
 	gint	target_width;
 	gint	target_height;
+
+	gboolean              has_region;
+	cairo_rectangle_int_t region;
 };
 
 
@@ -75,6 +79,9 @@ void             ev_render_context_set_target_size (EvRenderContext *rc,
                                                     int              target_width,
                                                     int              target_height);
 EV_PUBLIC
+void             ev_render_context_set_region      (EvRenderContext             *rc,
+                                                    const cairo_rectangle_int_t *region);
+EV_PUBLIC
 void             ev_render_context_compute_scaled_size      (EvRenderContext *rc,
                                                              double           width_points,
                                                              double           height_points,
@@ -20,17 +20,20 @@
 
 #include "ev-debug.h"
 #include "ev-job-scheduler.h"
+#include "ev-render-worker.h"
 
 typedef struct _EvSchedulerJob {
 	EvJob         *job;
 	EvJobPriority  priority;
+	gboolean       worker;
 	GSList        *job_link;
 } EvSchedulerJob;
 
 G_LOCK_DEFINE_STATIC(job_list);
 static GSList *job_list = NULL;
 
-static EvJob *running_job = NULL;
+G_LOCK_DEFINE_STATIC(running_jobs);
+static GList *running_jobs = NULL;
 
 static gpointer ev_job_thread_proxy               (gpointer        data);
 static void     ev_scheduler_thread_job_cancelled (EvSchedulerJob *job,
@@ -51,6 +54,27 @@ static GQueue *job_queue[EV_JOB_N_PRIORITIES] = {
 	&queue_none
 };
 
+/* Steps of jobs waiting for render worker processes, which don't use
+ * the documents of the viewer.
+ */
+static GQueue worker_queue_urgent = G_QUEUE_INIT;
+static GQueue worker_queue_high = G_QUEUE_INIT;
+static GQueue worker_queue_low = G_QUEUE_INIT;
+static GQueue worker_queue_none = G_QUEUE_INIT;
+
+static GQueue *worker_job_queue[EV_JOB_N_PRIORITIES] = {
+	&worker_queue_urgent,
+	&worker_queue_high,
+	&worker_queue_low,
+	&worker_queue_none
+};
+
+static GQueue **
+ev_job_queues (gboolean worker)
+{
+	return worker ? worker_job_queue : job_queue;
+}
+
 static void
 ev_job_queue_push (EvSchedulerJob *job,
 		   EvJobPriority   priority)
@@ -59,20 +83,51 @@ ev_job_queue_push (EvSchedulerJob *job,
 	
 	g_mutex_lock (&job_queue_mutex);
 
-	g_queue_push_tail (job_queue[priority], job);
+	g_queue_push_tail (ev_job_queues (job->worker)[priority], job);
 	g_cond_broadcast (&job_queue_cond);
 	
 	g_mutex_unlock (&job_queue_mutex);
 }
 
+/* Jobs running in several steps give the thread up between steps when
+ * there are more urgent jobs waiting, and go back to the head of their
+ * queue so that they are resumed before any other job of their priority.
+ */
+static gboolean
+ev_job_queue_requeue_if_preempted (EvSchedulerJob *job)
+{
+	GQueue **queues = ev_job_queues (job->worker);
+	gint     i;
+	gboolean preempted = FALSE;
+
+	g_mutex_lock (&job_queue_mutex);
+
+	for (i = EV_JOB_PRIORITY_URGENT; i < job->priority; i++) {
+		if (!g_queue_is_empty (queues[i])) {
+			preempted = TRUE;
+			break;
+		}
+	}
+
+	if (preempted) {
+		ev_debug_message (DEBUG_JOBS, "%s preempted", EV_GET_TYPE_NAME (job->job));
+		g_queue_push_head (queues[job->priority], job);
+	}
+
+	g_mutex_unlock (&job_queue_mutex);
+
+	return preempted;
+}
+
 static EvSchedulerJob *
-ev_job_queue_get_next_unlocked (void)
+ev_job_queue_get_next_unlocked (gboolean worker)
 {
+	GQueue **queues = ev_job_queues (worker);
 	gint i;
 	EvSchedulerJob *job = NULL;
 	
 	for (i = EV_JOB_PRIORITY_URGENT; i < EV_JOB_N_PRIORITIES; i++) {
-		job = (EvSchedulerJob *) g_queue_pop_head (job_queue[i]);
+		job = (EvSchedulerJob *) g_queue_pop_head (queues[i]);
 		if (job)
 			break;
 	}
@@ -82,10 +137,21 @@ ev_job_queue_get_next_unlocked (void)
 	return job;
 }
 
+/* Not every job takes the document lock, so all jobs using documents
+ * run in a single scheduler thread. When pages are rendered by worker
+ * processes, there's also a thread per worker waiting for it, which
+ * only runs the steps of render jobs moved to the worker queue.
+ */
 static gpointer
 ev_job_scheduler_init (gpointer data)
 {
-	g_thread_new ("EvJobScheduler", ev_job_thread_proxy, NULL);
+	guint n_workers, i;
+
+	g_thread_new ("EvJobScheduler", ev_job_thread_proxy, GINT_TO_POINTER (FALSE));
+
+	n_workers = ev_render_worker_get_n_workers ();
+	for (i = 0; i < n_workers; i++)
+		g_thread_new ("EvJobWorker", ev_job_thread_proxy, GINT_TO_POINTER (TRUE));
 
 	return NULL;
 }
@@ -148,6 +214,7 @@ static void
 ev_scheduler_thread_job_cancelled (EvSchedulerJob *job,
 				   GCancellable   *cancellable)
 {
+	GQueue  *queue;
 	GList   *list;
 	
 	ev_debug_message (DEBUG_JOBS, "%s", EV_GET_TYPE_NAME (job->job));
@@ -159,9 +226,10 @@ ev_scheduler_thread_job_cancelled (EvSchedulerJob *job,
 	 * If the job is currently running, it will be
 	 * destroyed as soon as it finishes. 
 	 */
-	list = g_queue_find (job_queue[job->priority], job);
+	queue = ev_job_queues (job->worker)[job->priority];
+	list = g_queue_find (queue, job);
 	if (list) {
-		g_queue_delete_link (job_queue[job->priority], list);
+		g_queue_delete_link (queue, list);
 		g_mutex_unlock (&job_queue_mutex);
 		ev_scheduler_job_destroy (job);
 	} else {
@@ -170,22 +238,50 @@ ev_scheduler_thread_job_cancelled (EvSchedulerJob *job,
 }
 
 static void
-ev_job_thread (EvJob *job)
+ev_job_thread_set_running (EvJob   *job,
+			   gboolean running)
+{
+	G_LOCK (running_jobs);
+	if (running)
+		running_jobs = g_list_prepend (running_jobs, job);
+	else
+		running_jobs = g_list_remove (running_jobs, job);
+	G_UNLOCK (running_jobs);
+}
+
+/* Returns FALSE if the job was put back in a queue before finishing */
+static gboolean
+ev_job_thread (EvSchedulerJob *s_job,
+	       gboolean        worker)
 {
+	EvJob   *job = s_job->job;
 	gboolean result;
 
 	ev_debug_message (DEBUG_JOBS, "%s", EV_GET_TYPE_NAME (job));
 
+	ev_job_thread_set_running (job, TRUE);
+
 	do {
 		if (g_cancellable_is_cancelled (job->cancellable))
 			result = FALSE;
-		else {
-                        g_atomic_pointer_set (&running_job, job);
+		else
 			result = ev_job_run (job);
-                }
+
+		if (result && s_job->worker != worker) {
+			ev_job_thread_set_running (job, FALSE);
+			ev_job_queue_push (s_job, s_job->priority);
+			return FALSE;
+		}
+
+		if (result && ev_job_queue_requeue_if_preempted (s_job)) {
+			ev_job_thread_set_running (job, FALSE);
+			return FALSE;
+		}
 	} while (result);
 
-        g_atomic_pointer_set (&running_job, NULL);
+	ev_job_thread_set_running (job, FALSE);
+
+	return TRUE;
 }
 
 static gboolean
@@ -202,11 +298,13 @@ ev_job_idle (EvJob *job)
 static gpointer
 ev_job_thread_proxy (gpointer data)
 {
+	gboolean worker = GPOINTER_TO_INT (data);
+
 	while (TRUE) {
 		EvSchedulerJob *job;
 
 		g_mutex_lock (&job_queue_mutex);
-		job = ev_job_queue_get_next_unlocked ();
+		job = ev_job_queue_get_next_unlocked (worker);
 		if (!job) {
 			g_cond_wait (&job_queue_cond, &job_queue_mutex);
 			g_mutex_unlock (&job_queue_mutex);
@@ -214,8 +312,8 @@ ev_job_thread_proxy (gpointer data)
 		}
 		g_mutex_unlock (&job_queue_mutex);
 		
-		ev_job_thread (job->job);
-		ev_scheduler_job_destroy (job);
+		if (ev_job_thread (job, worker))
+			ev_scheduler_job_destroy (job);
 	}
 
 	return NULL;
@@ -290,16 +388,18 @@ ev_job_scheduler_update_job (EvJob         *job,
 	G_UNLOCK (job_list);
 
 	if (need_resort) {
-		GList *list;
+		GQueue **queues;
+		GList   *list;
 	
 		g_mutex_lock (&job_queue_mutex);
 		
-		list = g_queue_find (job_queue[s_job->priority], s_job);
+		queues = ev_job_queues (s_job->worker);
+		list = g_queue_find (queues[s_job->priority], s_job);
 		if (list) {
 			ev_debug_message (DEBUG_JOBS, "Moving job %s from priority %d to %d",
 					  EV_GET_TYPE_NAME (job), s_job->priority, priority);
-			g_queue_delete_link (job_queue[s_job->priority], list);
-			g_queue_push_tail (job_queue[priority], s_job);
+			g_queue_delete_link (queues[s_job->priority], list);
+			g_queue_push_tail (queues[priority], s_job);
 			g_cond_broadcast (&job_queue_cond);
 		}
 		
@@ -307,13 +407,116 @@ ev_job_scheduler_update_job (EvJob         *job,
 	}
 }
 
+/* Removes from the queues the jobs of the same type as @job waiting to
+ * run that @can_share_result says can be completed with the result of
+ * @job, so that several consumers asking for the same thing get it from
+ * a single run. This must be called from the thread running @job, and
+ * the caller is responsible for completing the returned jobs.
+ */
+GList *
+_ev_job_scheduler_steal_pending_jobs (EvJob     *job,
+				      GEqualFunc can_share_result)
+{
+	GList *stolen = NULL;
+	GList *retval = NULL;
+	GList *l;
+	gint   i;
+
+	g_mutex_lock (&job_queue_mutex);
+
+	for (i = EV_JOB_PRIORITY_URGENT; i < EV_JOB_N_PRIORITIES; i++) {
+		l = job_queue[i]->head;
+		while (l) {
+			EvSchedulerJob *s_job = l->data;
+			GList          *next = l->next;
+
+			if (s_job->job != job &&
+			    G_OBJECT_TYPE (s_job->job) == G_OBJECT_TYPE (job) &&
+			    !g_cancellable_is_cancelled (s_job->job->cancellable) &&
+			    can_share_result (job, s_job->job)) {
+				g_queue_delete_link (job_queue[i], l);
+				stolen = g_list_prepend (stolen, s_job);
+			}
+
+			l = next;
+		}
+	}
+
+	g_mutex_unlock (&job_queue_mutex);
+
+	for (l = stolen; l; l = g_list_next (l)) {
+		EvSchedulerJob *s_job = l->data;
+
+		ev_debug_message (DEBUG_JOBS, "%s (%p) shares the result of %p",
+				  EV_GET_TYPE_NAME (s_job->job), s_job->job, job);
+
+		retval = g_list_prepend (retval, g_object_ref (s_job->job));
+		ev_scheduler_job_destroy (s_job);
+	}
+	g_list_free (stolen);
+
+	return retval;
+}
+
+/* Makes the next step of @job, which must be running in a scheduler
+ * thread and return %TRUE from its run method, run in a thread waiting
+ * for render workers when @worker is %TRUE, or in the thread using the
+ * documents otherwise.
+ */
+void
+_ev_job_scheduler_set_worker_step (EvJob   *job,
+				   gboolean worker)
+{
+	GSList *l;
+
+	G_LOCK (job_list);
+
+	for (l = job_list; l; l = l->next) {
+		EvSchedulerJob *s_job = (EvSchedulerJob *)l->data;
+
+		if (s_job->job == job) {
+			s_job->worker = worker;
+			break;
+		}
+	}
+
+	G_UNLOCK (job_list);
+}
+
 /**
  * ev_job_scheduler_get_running_thread_job:
  *
- * Returns: (transfer none): an #EvJob
+ * Returns: (transfer none): an #EvJob. When several jobs are running,
+ *   the one that started last.
  */
 EvJob *
 ev_job_scheduler_get_running_thread_job (void)
 {
-        return g_atomic_pointer_get (&running_job);
+	EvJob *job;
+
+	G_LOCK (running_jobs);
+	job = running_jobs ? running_jobs->data : NULL;
+	G_UNLOCK (running_jobs);
+
+	return job;
+}
+
+/**
+ * ev_job_scheduler_is_job_running:
+ * @job: an #EvJob
+ *
+ * Returns: whether @job is currently running in a scheduler thread
+ *
+ * Since: 43
+ */
+gboolean
+ev_job_scheduler_is_job_running (EvJob *job)
+{
+	gboolean running;
+
+	G_LOCK (running_jobs);
+	running = g_list_find (running_jobs, job) != NULL;
+	G_UNLOCK (running_jobs);
+
+	return running;
 }
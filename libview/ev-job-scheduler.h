@@ -47,5 +47,12 @@ void   ev_job_scheduler_update_job             (EvJob        *job,
                                                 EvJobPriority priority);
 EV_PUBLIC
 EvJob *ev_job_scheduler_get_running_thread_job (void);
+EV_PUBLIC
+gboolean ev_job_scheduler_is_job_running       (EvJob        *job);
+
+GList *_ev_job_scheduler_steal_pending_jobs    (EvJob        *job,
+                                                GEqualFunc    can_share_result);
+void   _ev_job_scheduler_set_worker_step       (EvJob        *job,
+                                                gboolean      worker);
 
 G_END_DECLS
@@ -21,6 +21,7 @@
 #include <config.h>
 
 #include "ev-jobs.h"
+#include "ev-job-scheduler.h"
 #include "ev-document-links.h"
 #include "ev-document-images.h"
 #include "ev-document-forms.h"
@@ -37,6 +38,8 @@
 #include "ev-document-attachments.h"
 #include "ev-document-media.h"
 #include "ev-document-text.h"
+#include "ev-render-worker.h"
+#include "ev-surface-broker.h"
 #include "ev-debug.h"
 
 #include <errno.h>
@@ -94,9 +97,15 @@ enum {
 	FIND_LAST_SIGNAL
 };
 
+enum {
+	ANNOTS_UPDATED,
+	ANNOTS_LAST_SIGNAL
+};
+
 static guint job_signals[LAST_SIGNAL] = { 0 };
 static guint job_fonts_signals[FONTS_LAST_SIGNAL] = { 0 };
 static guint job_find_signals[FIND_LAST_SIGNAL] = { 0 };
+static guint job_annots_signals[ANNOTS_LAST_SIGNAL] = { 0 };
 
 G_DEFINE_ABSTRACT_TYPE (EvJob, ev_job, G_TYPE_OBJECT)
 G_DEFINE_TYPE (EvJobLinks, ev_job_links, EV_TYPE_JOB)
@@ -348,18 +357,36 @@ ev_job_links_dispose (GObject *object)
 		job->model = NULL;
 	}
 
+	g_clear_pointer (&job->page_link_tree, g_tree_unref);
+
 	(* G_OBJECT_CLASS (ev_job_links_parent_class)->dispose) (object);
 }
 
+static gint
+page_link_tree_sort (gconstpointer a,
+		     gconstpointer b,
+		     gpointer      data)
+{
+	return GPOINTER_TO_INT (a) - GPOINTER_TO_INT (b);
+}
+
+/* Resolves the page of every link once, using it both for the page
+ * label column and for the index of the first link pointing to every
+ * page, which the outline uses to follow the current page.
+ */
 static gboolean
 fill_page_labels (GtkTreeModel   *tree_model,
 		  GtkTreePath    *path,
 		  GtkTreeIter    *iter,
-		  EvJob          *job)
+		  EvJobLinks     *job_links)
 {
-	EvDocumentLinks *document_links;
+	EvDocument      *document = EV_JOB (job_links)->document;
 	EvLink          *link;
 	gchar           *page_label;
+	gint             page;
+
+	if (g_cancellable_is_cancelled (EV_JOB (job_links)->cancellable))
+		return TRUE;
 
 	gtk_tree_model_get (tree_model, iter,
 			    EV_DOCUMENT_LINKS_COLUMN_LINK, &link,
@@ -368,8 +395,19 @@ fill_page_labels (GtkTreeModel   *tree_model,
 	if (!link)
 		return FALSE;
 
-	document_links = EV_DOCUMENT_LINKS (job->document);
-	page_label = ev_document_links_get_link_page_label (document_links, link);
+	page = ev_document_links_get_link_page (EV_DOCUMENT_LINKS (document), link);
+
+	/* Only save the first link we find per page. */
+	if (!g_tree_lookup (job_links->page_link_tree, GINT_TO_POINTER (page)))
+		g_tree_insert (job_links->page_link_tree, GINT_TO_POINTER (page), gtk_tree_path_copy (path));
+
+	/* Page label destinations keep their label even if no page has it */
+	if (page != -1)
+		page_label = ev_document_get_page_label (document, page);
+	else
+		page_label = ev_document_links_get_link_page_label (EV_DOCUMENT_LINKS (document), link);
+	g_object_unref (link);
+
 	if (!page_label)
 		return FALSE;
 
@@ -378,7 +416,6 @@ fill_page_labels (GtkTreeModel   *tree_model,
 			    -1);
 
 	g_free (page_label);
-	g_object_unref (link);
 
 	return FALSE;
 }
@@ -395,7 +432,10 @@ ev_job_links_run (EvJob *job)
 	job_links->model = ev_document_links_get_links_model (EV_DOCUMENT_LINKS (job->document));
 	ev_document_doc_mutex_unlock ();
 
-	gtk_tree_model_foreach (job_links->model, (GtkTreeModelForeachFunc)fill_page_labels, job);
+	job_links->page_link_tree = g_tree_new_full (page_link_tree_sort, NULL, NULL,
+						    (GDestroyNotify) gtk_tree_path_free);
+	if (job_links->model)
+		gtk_tree_model_foreach (job_links->model, (GtkTreeModelForeachFunc)fill_page_labels, job_links);
 
 	ev_job_succeeded (job);
 	
@@ -441,6 +481,24 @@ ev_job_links_get_model (EvJobLinks *job)
 	return job->model;
 }
 
+/**
+ * ev_job_links_get_page_link_tree: (skip)
+ * @job: #EvJobLinks
+ *
+ * Get a #GTree mapping page indexes to the #GtkTreePath of the first
+ * link in the model pointing to that page. Links whose page can't be
+ * resolved are indexed as page -1.
+ *
+ * Return value: (transfer none): The #GTree of page links
+ *
+ * Since: 43
+ */
+GTree *
+ev_job_links_get_page_link_tree (EvJobLinks *job)
+{
+	return job->page_link_tree;
+}
+
 /* EvJobAttachments */
 static void
 ev_job_attachments_init (EvJobAttachments *job)
@@ -508,10 +566,24 @@ ev_job_attachments_new (EvDocument *document)
 }
 
 /* EvJobAnnots */
+#define ANNOTS_SCAN_PAGES 10
+
 static void
 ev_job_annots_init (EvJobAnnots *job)
 {
 	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+
+	g_mutex_init (&job->mutex);
+}
+
+static void
+ev_job_annots_finalize (GObject *object)
+{
+	EvJobAnnots *job = EV_JOB_ANNOTS (object);
+
+	g_mutex_clear (&job->mutex);
+
+	G_OBJECT_CLASS (ev_job_annots_parent_class)->finalize (object);
 }
 
 static void
@@ -529,32 +601,82 @@ ev_job_annots_dispose (GObject *object)
 		job->annots = NULL;
 	}
 
+	g_list_free_full (job->new_annots, (GDestroyNotify) ev_mapping_list_unref);
+	job->new_annots = NULL;
+
 	G_OBJECT_CLASS (ev_job_annots_parent_class)->dispose (object);
 }
 
+static gboolean
+ev_job_annots_emit_updated (EvJobAnnots *job)
+{
+	g_mutex_lock (&job->mutex);
+	job->updated_idle_id = 0;
+	g_mutex_unlock (&job->mutex);
+
+	if (!EV_JOB (job)->cancelled)
+		g_signal_emit (job, job_annots_signals[ANNOTS_UPDATED], 0);
+
+	return G_SOURCE_REMOVE;
+}
+
 static gboolean
 ev_job_annots_run (EvJob *job)
 {
 	EvJobAnnots *job_annots = EV_JOB_ANNOTS (job);
+	GList       *new_annots = NULL;
+	gint         n_pages;
 	gint         i;
 
 	ev_debug_message (DEBUG_JOBS, NULL);
-	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 
-	ev_document_doc_mutex_lock ();
-	for (i = 0; i < ev_document_get_n_pages (job->document); i++) {
+	if (job_annots->n_scanned_pages == 0)
+		ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
+
+	/* Pages are scanned a few at a time, locking the document for
+	 * every page, so that rendering isn't blocked while annotations
+	 * are loaded and the sidebar can show them as they are found.
+	 */
+	n_pages = ev_document_get_n_pages (job->document);
+	for (i = job_annots->n_scanned_pages;
+	     i < MIN (n_pages, job_annots->n_scanned_pages + ANNOTS_SCAN_PAGES);
+	     i++) {
 		EvMappingList *mapping_list;
 		EvPage        *page;
 
+		ev_document_doc_mutex_lock ();
 		page = ev_document_get_page (job->document, i);
 		mapping_list = ev_document_annotations_get_annotations (EV_DOCUMENT_ANNOTATIONS (job->document),
 									page);
 		g_object_unref (page);
+		ev_document_doc_mutex_unlock ();
 
-		if (mapping_list)
+		if (mapping_list) {
 			job_annots->annots = g_list_prepend (job_annots->annots, mapping_list);
+			new_annots = g_list_prepend (new_annots, ev_mapping_list_ref (mapping_list));
+		}
+	}
+	job_annots->n_scanned_pages = i;
+
+	if (new_annots) {
+		g_mutex_lock (&job_annots->mutex);
+		job_annots->new_annots = g_list_concat (job_annots->new_annots,
+							g_list_reverse (new_annots));
+		/* Added before the finished idle, so the last annotations
+		 * are always delivered before the job finishes.
+		 */
+		if (job_annots->updated_idle_id == 0) {
+			job_annots->updated_idle_id =
+				g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+						 (GSourceFunc) ev_job_annots_emit_updated,
+						 g_object_ref (job_annots),
+						 (GDestroyNotify) g_object_unref);
+		}
+		g_mutex_unlock (&job_annots->mutex);
 	}
-	ev_document_doc_mutex_unlock ();
+
+	if (job_annots->n_scanned_pages < n_pages)
+		return TRUE;
 
 	job_annots->annots = g_list_reverse (job_annots->annots);
 
@@ -570,7 +692,17 @@ ev_job_annots_class_init (EvJobAnnotsClass *class)
 	EvJobClass   *job_class = EV_JOB_CLASS (class);
 
 	oclass->dispose = ev_job_annots_dispose;
+	oclass->finalize = ev_job_annots_finalize;
 	job_class->run = ev_job_annots_run;
+
+	job_annots_signals[ANNOTS_UPDATED] =
+		g_signal_new ("updated",
+			      EV_TYPE_JOB_ANNOTS,
+			      G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (EvJobAnnotsClass, updated),
+			      NULL, NULL,
+			      g_cclosure_marshal_VOID__VOID,
+			      G_TYPE_NONE, 0);
 }
 
 EvJob *
@@ -586,6 +718,35 @@ ev_job_annots_new (EvDocument *document)
 	return job;
 }
 
+/**
+ * ev_job_annots_take_new_annots:
+ * @job: an #EvJobAnnots
+ *
+ * Gets the annotations found by @job since the last call, one
+ * #EvMappingList per page in page order. This is meant to be called
+ * from the #EvJobAnnots::updated handler to show the annotations while
+ * the rest of the document is still being scanned.
+ *
+ * Returns: (transfer full) (element-type EvMappingList): the new
+ *   annotations. Free with g_list_free_full() and ev_mapping_list_unref().
+ *
+ * Since: 43
+ */
+GList *
+ev_job_annots_take_new_annots (EvJobAnnots *job)
+{
+	GList *new_annots;
+
+	g_return_val_if_fail (EV_IS_JOB_ANNOTS (job), NULL);
+
+	g_mutex_lock (&job->mutex);
+	new_annots = job->new_annots;
+	job->new_annots = NULL;
+	g_mutex_unlock (&job->mutex);
+
+	return new_annots;
+}
+
 /* EvJobRender */
 static void
 ev_job_render_init (EvJobRender *job)
@@ -617,9 +778,159 @@ ev_job_render_dispose (GObject *object)
 		job->selection_region = NULL;
 	}
 
+	g_clear_object (&job->rc);
+
 	(* G_OBJECT_CLASS (ev_job_render_parent_class)->dispose) (object);
 }
 
+/* Returns a copy of @surface that consumers can modify in place */
+static cairo_surface_t *
+copy_surface_scaled (cairo_surface_t *surface,
+		     gint             width,
+		     gint             height)
+{
+	cairo_surface_t *copy;
+	cairo_t         *cr;
+
+	copy = cairo_image_surface_create (cairo_image_surface_get_format (surface),
+					   width, height);
+	cr = cairo_create (copy);
+	if (width != cairo_image_surface_get_width (surface) ||
+	    height != cairo_image_surface_get_height (surface)) {
+		cairo_scale (cr,
+			     (gdouble) width / cairo_image_surface_get_width (surface),
+			     (gdouble) height / cairo_image_surface_get_height (surface));
+		cairo_set_source_surface (cr, surface, 0, 0);
+		cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_GOOD);
+	} else {
+		cairo_set_source_surface (cr, surface, 0, 0);
+	}
+	cairo_paint (cr);
+	cairo_destroy (cr);
+
+	return copy;
+}
+
+/* Pending render jobs for the same page of the same document can be
+ * completed by downscaling the page rendered by @a, as long as they
+ * are not larger and have the same aspect ratio, within a pixel.
+ * Regions are only shared when they are exactly the same.
+ */
+static gboolean
+ev_job_render_can_share_result (gconstpointer a,
+				gconstpointer b)
+{
+	const EvJobRender *job = a;
+	const EvJobRender *pending = b;
+
+	if (EV_JOB (job)->document != EV_JOB (pending)->document ||
+	    job->page != pending->page ||
+	    job->rotation != pending->rotation ||
+	    job->target_width <= 0 || job->target_height <= 0 ||
+	    pending->include_selection)
+		return FALSE;
+
+	if (job->has_region || pending->has_region) {
+		return job->has_region && pending->has_region &&
+			job->region.x == pending->region.x &&
+			job->region.y == pending->region.y &&
+			job->region.width == pending->region.width &&
+			job->region.height == pending->region.height &&
+			job->target_width == pending->target_width &&
+			job->target_height == pending->target_height;
+	}
+
+	if (pending->target_width > job->target_width ||
+	    pending->target_height > job->target_height)
+		return FALSE;
+
+	return ABS (pending->target_width * job->target_height -
+		    pending->target_height * job->target_width) <=
+		MAX (job->target_width, job->target_height);
+}
+
+static void
+ev_job_render_share_result (EvJobRender *job_render)
+{
+	GList *pending, *l;
+
+	if (cairo_surface_get_type (job_render->surface) != CAIRO_SURFACE_TYPE_IMAGE)
+		return;
+
+	pending = _ev_job_scheduler_steal_pending_jobs (EV_JOB (job_render),
+							ev_job_render_can_share_result);
+	for (l = pending; l; l = g_list_next (l)) {
+		EvJobRender *pending_render = l->data;
+		gint         width, height;
+
+		/* Backends don't always honor the target size */
+		width = cairo_image_surface_get_width (job_render->surface);
+		height = cairo_image_surface_get_height (job_render->surface);
+		if (pending_render->target_width != job_render->target_width ||
+		    pending_render->target_height != job_render->target_height) {
+			width = MAX (1, width * pending_render->target_width / job_render->target_width);
+			height = MAX (1, height * pending_render->target_height / job_render->target_height);
+		}
+
+		pending_render->surface = copy_surface_scaled (job_render->surface, width, height);
+		ev_job_succeeded (EV_JOB (pending_render));
+	}
+	g_list_free_full (pending, g_object_unref);
+}
+
+static EvRenderContext *
+ev_job_render_new_context (EvJobRender *job_render,
+			   EvPage      *page)
+{
+	EvRenderContext *rc;
+
+	rc = ev_render_context_new (page, job_render->rotation, job_render->scale);
+	ev_render_context_set_target_size (rc,
+					   job_render->target_width, job_render->target_height);
+	if (job_render->has_region)
+		ev_render_context_set_region (rc, &job_render->region);
+
+	return rc;
+}
+
+/* Runs in a thread waiting for render workers, so it must not use the
+ * document, and its render context has a page without backend data.
+ * Pages that the worker couldn't render, and selections, are rendered
+ * back in the thread using the document.
+ */
+static gboolean
+ev_job_render_run_in_worker (EvJobRender *job_render)
+{
+	EvJob *job = EV_JOB (job_render);
+
+	ev_debug_message (DEBUG_JOBS, "page: %d (%p)", job_render->page, job);
+
+	job_render->worker_done = TRUE;
+	ev_render_worker_render (job->document, job_render->rc,
+				 job->cancellable,
+				 &job_render->surface);
+	g_clear_object (&job_render->rc);
+
+	if (g_cancellable_is_cancelled (job->cancellable))
+		return FALSE;
+
+	if (job_render->surface &&
+	    cairo_surface_status (job_render->surface) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy (job_render->surface);
+		job_render->surface = NULL;
+	}
+
+	if (!job_render->surface || job_render->include_selection) {
+		_ev_job_scheduler_set_worker_step (job, FALSE);
+		return TRUE;
+	}
+
+	ev_job_render_share_result (job_render);
+	ev_job_succeeded (job);
+
+	return FALSE;
+}
+
 static gboolean
 ev_job_render_run (EvJob *job)
 {
@@ -627,6 +938,9 @@ ev_job_render_run (EvJob *job)
 	EvPage          *ev_page;
 	EvRenderContext *rc;
 
+	if (job_render->rc)
+		return ev_job_render_run_in_worker (job_render);
+
 	ev_debug_message (DEBUG_JOBS, "page: %d (%p)", job_render->page, job);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 	
@@ -636,13 +950,28 @@ ev_job_render_run (EvJob *job)
 		
 	ev_document_fc_mutex_lock ();
 
+	/* Render workers don't use our copy of the document, so other jobs
+	 * can use it while the page is being rendered.
+	 */
+	if (!job_render->worker_done && ev_render_worker_can_render (job->document)) {
+		ev_document_fc_mutex_unlock ();
+		ev_document_doc_mutex_unlock ();
+
+		ev_page = ev_page_new (job_render->page);
+		job_render->rc = ev_job_render_new_context (job_render, ev_page);
+		g_object_unref (ev_page);
+
+		_ev_job_scheduler_set_worker_step (job, TRUE);
+
+		return TRUE;
+	}
+
 	ev_page = ev_document_get_page (job->document, job_render->page);
-	rc = ev_render_context_new (ev_page, job_render->rotation, job_render->scale);
-	ev_render_context_set_target_size (rc,
-					   job_render->target_width, job_render->target_height);
+	rc = ev_job_render_new_context (job_render, ev_page);
 	g_object_unref (ev_page);
 
-	job_render->surface = ev_document_render (job->document, rc);
+	if (!job_render->surface)
+		job_render->surface = ev_document_render (job->document, rc);
 
 	if (job_render->surface == NULL ||
 	    cairo_surface_status (job_render->surface) != CAIRO_STATUS_SUCCESS) {
@@ -699,7 +1028,8 @@ ev_job_render_run (EvJob *job)
 
 	ev_document_fc_mutex_unlock ();
 	ev_document_doc_mutex_unlock ();
-	
+
+	ev_job_render_share_result (job_render);
 	ev_job_succeeded (job);
 	
 	return FALSE;
@@ -754,6 +1084,28 @@ ev_job_render_set_selection_info (EvJobRender     *job,
 	job->base = *base;
 }
 
+/**
+ * ev_job_render_set_region:
+ * @job: an #EvJobRender
+ * @region: (nullable): the area of the page to render, or %NULL
+ *
+ * Only render @region of the page, in pixels of the scaled and rotated
+ * page. See ev_render_context_set_region().
+ *
+ * Since: 43
+ */
+void
+ev_job_render_set_region (EvJobRender                 *job,
+			  const cairo_rectangle_int_t *region)
+{
+	if (region) {
+		job->has_region = TRUE;
+		job->region = *region;
+	} else {
+		job->has_region = FALSE;
+	}
+}
+
 /* EvJobPageData */
 static void
 ev_job_page_data_init (EvJobPageData *job)
@@ -877,13 +1229,61 @@ ev_job_thumbnail_dispose (GObject *object)
 	(* G_OBJECT_CLASS (ev_job_thumbnail_parent_class)->dispose) (object);
 }
 
+/* Thumbnails are only shared when they are exactly the same */
+static gboolean
+ev_job_thumbnail_can_share_result (gconstpointer a,
+				   gconstpointer b)
+{
+	const EvJobThumbnail *job = a;
+	const EvJobThumbnail *pending = b;
+
+	return EV_JOB (job)->document == EV_JOB (pending)->document &&
+		job->page == pending->page &&
+		job->rotation == pending->rotation &&
+		job->scale == pending->scale &&
+		job->target_width == pending->target_width &&
+		job->target_height == pending->target_height &&
+		job->format == pending->format &&
+		job->has_frame == pending->has_frame;
+}
+
+static void
+ev_job_thumbnail_share_result (EvJobThumbnail *job_thumb)
+{
+	GList *pending, *l;
+
+	if (job_thumb->thumbnail_surface &&
+	    cairo_surface_get_type (job_thumb->thumbnail_surface) != CAIRO_SURFACE_TYPE_IMAGE)
+		return;
+
+	pending = _ev_job_scheduler_steal_pending_jobs (EV_JOB (job_thumb),
+							ev_job_thumbnail_can_share_result);
+	for (l = pending; l; l = g_list_next (l)) {
+		EvJobThumbnail *pending_thumb = l->data;
+
+		if (job_thumb->thumbnail)
+			pending_thumb->thumbnail = gdk_pixbuf_copy (job_thumb->thumbnail);
+		if (job_thumb->thumbnail_surface) {
+			pending_thumb->thumbnail_surface =
+				copy_surface_scaled (job_thumb->thumbnail_surface,
+						     cairo_image_surface_get_width (job_thumb->thumbnail_surface),
+						     cairo_image_surface_get_height (job_thumb->thumbnail_surface));
+		}
+		ev_job_succeeded (EV_JOB (pending_thumb));
+	}
+	g_list_free_full (pending, g_object_unref);
+}
+
 static gboolean
 ev_job_thumbnail_run (EvJob *job)
 {
 	EvJobThumbnail  *job_thumb = EV_JOB_THUMBNAIL (job);
 	EvRenderContext *rc;
 	GdkPixbuf       *pixbuf = NULL;
+	cairo_surface_t *surface;
 	EvPage          *page;
+	gdouble          page_width, page_height;
+	gint             width, height;
 
 	ev_debug_message (DEBUG_JOBS, "%d (%p)", job_thumb->page, job);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
@@ -896,10 +1296,29 @@ ev_job_thumbnail_run (EvJob *job)
 					   job_thumb->target_width, job_thumb->target_height);
 	g_object_unref (page);
 
-        if (job_thumb->format == EV_JOB_THUMBNAIL_PIXBUF)
-                pixbuf = ev_document_get_thumbnail (job->document, rc);
-        else
-                job_thumb->thumbnail_surface = ev_document_get_thumbnail_surface (job->document, rc);
+	/* Downscale the page already rendered by the view if there's one,
+	 * it's much cheaper than rendering it again.
+	 */
+	ev_document_get_page_size (job->document, job_thumb->page,
+				   &page_width, &page_height);
+	ev_render_context_compute_transformed_size (rc, page_width, page_height,
+						    &width, &height);
+	surface = ev_surface_broker_scale_surface (job->document, job_thumb->page,
+						   job_thumb->rotation, width, height);
+	if (surface) {
+		ev_debug_message (DEBUG_JOBS, "%d (%p) reused rendered page", job_thumb->page, job);
+
+		if (job_thumb->format == EV_JOB_THUMBNAIL_PIXBUF) {
+			pixbuf = ev_document_misc_pixbuf_from_surface (surface);
+			cairo_surface_destroy (surface);
+		} else {
+			job_thumb->thumbnail_surface = surface;
+		}
+	} else if (job_thumb->format == EV_JOB_THUMBNAIL_PIXBUF) {
+		pixbuf = ev_document_get_thumbnail (job->document, rc);
+	} else {
+		job_thumb->thumbnail_surface = ev_document_get_thumbnail_surface (job->document, rc);
+	}
 	g_object_unref (rc);
 	ev_document_doc_mutex_unlock ();
 
@@ -918,6 +1337,7 @@ ev_job_thumbnail_run (EvJob *job)
 			       _("Failed to create thumbnail for page %d"),
 			       job_thumb->page);
 	} else {
+		ev_job_thumbnail_share_result (job_thumb);
 		ev_job_succeeded (job);
 	}
 	
@@ -1005,10 +1425,43 @@ ev_job_thumbnail_set_output_format (EvJobThumbnail      *job,
 }
 
 /* EvJobFonts */
+#define FONTS_SCAN_PAGES 20
+
 static void
 ev_job_fonts_init (EvJobFonts *job)
 {
-	EV_JOB (job)->run_mode = EV_JOB_RUN_MAIN_LOOP;
+	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+
+	g_mutex_init (&job->mutex);
+}
+
+static void
+ev_job_fonts_finalize (GObject *object)
+{
+	EvJobFonts *job = EV_JOB_FONTS (object);
+
+	ev_debug_message (DEBUG_JOBS, NULL);
+
+	g_clear_pointer (&job->fonts, g_ptr_array_unref);
+	g_mutex_clear (&job->mutex);
+
+	(* G_OBJECT_CLASS (ev_job_fonts_parent_class)->finalize) (object);
+}
+
+static gboolean
+ev_job_fonts_emit_updated (EvJobFonts *job)
+{
+	gdouble progress;
+
+	g_mutex_lock (&job->mutex);
+	job->updated_idle_id = 0;
+	progress = job->progress;
+	g_mutex_unlock (&job->mutex);
+
+	if (!EV_JOB (job)->cancelled)
+		g_signal_emit (job, job_fonts_signals[FONTS_UPDATED], 0, progress);
+
+	return G_SOURCE_REMOVE;
 }
 
 static gboolean
@@ -1016,40 +1469,67 @@ ev_job_fonts_run (EvJob *job)
 {
 	EvJobFonts      *job_fonts = EV_JOB_FONTS (job);
 	EvDocumentFonts *fonts = EV_DOCUMENT_FONTS (job->document);
+	GPtrArray       *batch;
+	gdouble          progress;
+	guint            i;
 
 	ev_debug_message (DEBUG_JOBS, NULL);
-	
-	/* Do not block the main loop */
-	if (!ev_document_doc_mutex_trylock ())
-		return TRUE;
-	
-	if (!ev_document_fc_mutex_trylock ())
-		return TRUE;
 
 #ifdef EV_ENABLE_DEBUG
 	/* We use the #ifdef in this case because of the if */
-	if (ev_document_fonts_get_progress (fonts) == 0)
+	if (job_fonts->progress == 0)
 		ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 #endif
 
-	job_fonts->scan_completed = !ev_document_fonts_scan (fonts, 20);
-	g_signal_emit (job_fonts, job_fonts_signals[FONTS_UPDATED], 0,
-		       ev_document_fonts_get_progress (fonts));
+	/* The names and details of the fonts found in every step are
+	 * collected as plain strings, and the rows are only created by
+	 * ev_job_fonts_fill_model() in the main thread, so the document
+	 * is never accessed from there and no GTK object is created here.
+	 */
+	batch = g_ptr_array_new ();
+
+	ev_document_doc_mutex_lock ();
+	ev_document_fc_mutex_lock ();
+
+	job_fonts->scan_completed = !ev_document_fonts_scan (fonts, FONTS_SCAN_PAGES);
+	progress = ev_document_fonts_get_progress (fonts);
+	ev_document_fonts_get_fonts (fonts, batch);
 
 	ev_document_fc_mutex_unlock ();
 	ev_document_doc_mutex_unlock ();
 
+	g_mutex_lock (&job_fonts->mutex);
+	if (!job_fonts->fonts)
+		job_fonts->fonts = g_ptr_array_new_with_free_func (g_free);
+	for (i = 0; i < batch->len; i++)
+		g_ptr_array_add (job_fonts->fonts, g_ptr_array_index (batch, i));
+	job_fonts->progress = progress;
+	/* The idle is added before the finished one, so the last fonts
+	 * are always delivered before the job finishes.
+	 */
+	if (job_fonts->updated_idle_id == 0) {
+		job_fonts->updated_idle_id =
+			g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+					 (GSourceFunc) ev_job_fonts_emit_updated,
+					 g_object_ref (job_fonts),
+					 (GDestroyNotify) g_object_unref);
+	}
+	g_mutex_unlock (&job_fonts->mutex);
+	g_ptr_array_free (batch, TRUE);
+
 	if (job_fonts->scan_completed)
 		ev_job_succeeded (job);
-	
+
 	return !job_fonts->scan_completed;
 }
 
 static void
 ev_job_fonts_class_init (EvJobFontsClass *class)
 {
-	EvJobClass *job_class = EV_JOB_CLASS (class);
-	
+	GObjectClass *oclass = G_OBJECT_CLASS (class);
+	EvJobClass   *job_class = EV_JOB_CLASS (class);
+
+	oclass->finalize = ev_job_fonts_finalize;
 	job_class->run = ev_job_fonts_run;
 	
 	job_fonts_signals[FONTS_UPDATED] =
@@ -1077,6 +1557,48 @@ ev_job_fonts_new (EvDocument *document)
 	return EV_JOB (job);
 }
 
+/**
+ * ev_job_fonts_fill_model:
+ * @job: an #EvJobFonts
+ * @model: a #GtkTreeModel with %EV_DOCUMENT_FONTS_COLUMN_NUM_COLUMNS string columns
+ *
+ * Appends to @model the fonts found by @job since the last call. This
+ * is meant to be called from the #EvJobFonts::updated handler, and it
+ * doesn't need to lock the document.
+ *
+ * Since: 43
+ */
+void
+ev_job_fonts_fill_model (EvJobFonts   *job,
+			 GtkTreeModel *model)
+{
+	GPtrArray *fonts;
+	guint      i;
+
+	g_return_if_fail (EV_IS_JOB_FONTS (job));
+	g_return_if_fail (GTK_IS_LIST_STORE (model));
+
+	g_mutex_lock (&job->mutex);
+	fonts = job->fonts;
+	job->fonts = NULL;
+	g_mutex_unlock (&job->mutex);
+
+	if (!fonts)
+		return;
+
+	/* Names and details are stored one after the other */
+	for (i = 0; i + 1 < fonts->len; i += 2) {
+		GtkTreeIter iter;
+
+		gtk_list_store_insert_with_values (GTK_LIST_STORE (model), &iter, -1,
+						   EV_DOCUMENT_FONTS_COLUMN_NAME, g_ptr_array_index (fonts, i),
+						   EV_DOCUMENT_FONTS_COLUMN_DETAILS, g_ptr_array_index (fonts, i + 1),
+						   -1);
+	}
+
+	g_ptr_array_unref (fonts);
+}
+
 /* EvJobLoad */
 static void
 ev_job_load_init (EvJobLoad *job)
@@ -1132,12 +1654,14 @@ ev_job_load_run (EvJob *job)
 
 		uncompressed_uri = g_object_get_data (G_OBJECT (job->document),
 						      "uri-uncompressed");
-		ev_document_load (job->document,
-				  uncompressed_uri ? uncompressed_uri : job_load->uri,
-				  &error);
+		ev_document_load_full (job->document,
+				       uncompressed_uri ? uncompressed_uri : job_load->uri,
+				       job_load->flags,
+				       &error);
 	} else {
-		job->document = ev_document_factory_get_document (job_load->uri,
-								  &error);
+		job->document = ev_document_factory_get_document_full (job_load->uri,
+								       job_load->flags,
+								       &error);
 	}
 
 	ev_document_fc_mutex_unlock ();
@@ -1146,6 +1670,7 @@ ev_job_load_run (EvJob *job)
 		ev_job_failed_from_error (job, error);
 		g_error_free (error);
 	} else {
+		ev_render_worker_document_loaded (job->document);
 		ev_job_succeeded (job);
 	}
 
@@ -1195,6 +1720,22 @@ ev_job_load_set_password (EvJobLoad *job, const gchar *password)
 	job->password = password ? g_strdup (password) : NULL;
 }
 
+/**
+ * ev_job_load_set_load_flags:
+ * @job: an #EvJobLoad
+ * @flags: flags from #EvDocumentLoadFlags
+ *
+ * Since: 43
+ */
+void
+ev_job_load_set_load_flags (EvJobLoad          *job,
+			    EvDocumentLoadFlags flags)
+{
+	g_return_if_fail (EV_IS_JOB_LOAD (job));
+
+	job->flags = flags;
+}
+
 /* EvJobLoadStream */
 
 /**
@@ -1801,6 +2342,54 @@ ev_job_save_dispose (GObject *object)
 	(* G_OBJECT_CLASS (ev_job_save_parent_class)->dispose) (object);
 }
 
+/* When overwriting a local file, the document is saved to a temporary
+ * file in the same directory, which then replaces the target with a
+ * rename. That avoids writing the whole document a second time to copy
+ * it from the temporary directory, which is most of the time spent when
+ * saving a few annotations on a big document. The target is only
+ * replaced when that doesn't change its owner, permissions or links,
+ * and after the new contents reached the disk, otherwise a crash right
+ * after the rename could leave an empty target.
+ */
+static gchar *
+ev_job_save_create_replacement_file (const gchar *uri)
+{
+	gchar    *filename;
+	gchar    *dirname;
+	gchar    *basename;
+	gchar    *tmp_filename;
+	GStatBuf  st;
+	gint      fd;
+
+	filename = g_filename_from_uri (uri, NULL, NULL);
+	if (!filename)
+		return NULL;
+
+	if (g_lstat (filename, &st) != 0 || !S_ISREG (st.st_mode) ||
+	    st.st_nlink > 1 || st.st_uid != getuid ()) {
+		g_free (filename);
+
+		return NULL;
+	}
+
+	dirname = g_path_get_dirname (filename);
+	basename = g_path_get_basename (filename);
+	tmp_filename = g_strdup_printf ("%s%c.%s.XXXXXX", dirname, G_DIR_SEPARATOR, basename);
+	g_free (dirname);
+	g_free (basename);
+	g_free (filename);
+
+	fd = g_mkstemp_full (tmp_filename, O_RDWR, st.st_mode & 07777);
+	if (fd == -1) {
+		g_free (tmp_filename);
+
+		return NULL;
+	}
+	close (fd);
+
+	return tmp_filename;
+}
+
 static gboolean
 ev_job_save_run (EvJob *job)
 {
@@ -1808,19 +2397,82 @@ ev_job_save_run (EvJob *job)
 	gint       fd;
 	gchar     *tmp_filename = NULL;
 	gchar     *local_uri;
+	gboolean   compressed;
 	GError    *error = NULL;
 	
 	ev_debug_message (DEBUG_JOBS, "uri: %s, document_uri: %s", job_save->uri, job_save->document_uri);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 
-        fd = ev_mkstemp ("saveacopy.XXXXXX", &tmp_filename, &error);
-        if (fd == -1) {
-                ev_job_failed_from_error (job, error);
-                g_error_free (error);
+	compressed = g_object_get_data (G_OBJECT (job->document), "uri-uncompressed") != NULL;
+	if (!compressed)
+		tmp_filename = ev_job_save_create_replacement_file (job_save->uri);
+
+	if (!tmp_filename) {
+		fd = ev_mkstemp ("saveacopy.XXXXXX", &tmp_filename, &error);
+		if (fd == -1) {
+			ev_job_failed_from_error (job, error);
+			g_error_free (error);
+
+			return FALSE;
+		}
+		close (fd);
+	} else {
+		gchar *filename;
+
+		ev_document_doc_mutex_lock ();
+
+		local_uri = g_filename_to_uri (tmp_filename, NULL, &error);
+		if (local_uri != NULL) {
+			ev_document_save (job->document, local_uri, &error);
+			g_free (local_uri);
+		}
+
+		ev_document_doc_mutex_unlock ();
+
+		/* Backends write the file on their own, so it's opened
+		 * again to be synced.
+		 */
+		if (!error) {
+			fd = g_open (tmp_filename, O_RDONLY, 0);
+			if (fd == -1 || fsync (fd) != 0) {
+				int errsv = errno;
+
+				g_set_error (&error, G_IO_ERROR,
+					     g_io_error_from_errno (errsv),
+					     _("Failed to save document to “%s”: %s"),
+					     job_save->uri, g_strerror (errsv));
+			}
+			if (fd != -1)
+				close (fd);
+		}
+
+		filename = g_filename_from_uri (job_save->uri, NULL, NULL);
+		if (!error && g_rename (tmp_filename, filename) != 0) {
+			int errsv = errno;
+
+			g_set_error (&error, G_IO_ERROR,
+				     g_io_error_from_errno (errsv),
+				     _("Failed to save document to “%s”: %s"),
+				     job_save->uri, g_strerror (errsv));
+		}
+		if (error)
+			g_unlink (tmp_filename);
+		g_free (filename);
+		g_free (tmp_filename);
+
+		/* Copy the metadata from the original file */
+		if (!error)
+			ev_file_copy_metadata (job_save->document_uri, job_save->uri, NULL);
+
+		if (error) {
+			ev_job_failed_from_error (job, error);
+			g_error_free (error);
+		} else {
+			ev_job_succeeded (job);
+		}
 
 		return FALSE;
 	}
-	close (fd);
 
 	ev_document_doc_mutex_lock ();
 
@@ -1843,7 +2495,7 @@ ev_job_save_run (EvJob *job)
 	/* If original document was compressed,
 	 * compress it again before saving
 	 */
-	if (g_object_get_data (G_OBJECT (job->document), "uri-uncompressed")) {
+	if (compressed) {
 		EvCompressionType ctype = EV_COMPRESSION_NONE;
 		const gchar      *ext;
 		gchar            *uri_comp;
@@ -2191,11 +2843,18 @@ ev_job_layers_new (EvDocument *document)
 }
 
 /* EvJobExport */
+typedef struct {
+	gint     page;
+	gboolean begin_sheet;
+	gboolean end_sheet;
+} EvJobExportPage;
+
 static void
 ev_job_export_init (EvJobExport *job)
 {
 	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
 	job->page = -1;
+	job->pages = g_array_new (FALSE, FALSE, sizeof (EvJobExportPage));
 }
 
 static void
@@ -2212,40 +2871,73 @@ ev_job_export_dispose (GObject *object)
 		job->rc = NULL;
 	}
 
+	g_clear_pointer (&job->pages, g_array_unref);
+
 	(* G_OBJECT_CLASS (ev_job_export_parent_class)->dispose) (object);
 }
 
+static void
+ev_job_export_do_page (EvJobExport *job_export,
+		       gint         page)
+{
+	EvJob  *job = EV_JOB (job_export);
+	EvPage *ev_page;
+
+	ev_page = ev_document_get_page (job->document, page);
+	if (job_export->rc)
+		ev_render_context_set_page (job_export->rc, ev_page);
+	else
+		job_export->rc = ev_render_context_new (ev_page, 0, 1.0);
+	g_object_unref (ev_page);
+
+	ev_file_exporter_do_page (EV_FILE_EXPORTER (job->document), job_export->rc);
+}
+
 static gboolean
 ev_job_export_run (EvJob *job)
 {
 	EvJobExport *job_export = EV_JOB_EXPORT (job);
-	EvPage      *ev_page;
+	guint        i;
 
-	g_assert (job_export->page != -1);
+	g_assert (job_export->page != -1 || job_export->pages->len > 0);
 
 	ev_debug_message (DEBUG_JOBS, NULL);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
-	
-	ev_document_doc_mutex_lock ();
-	
-	ev_page = ev_document_get_page (job->document, job_export->page);
-	if (job_export->rc) {
-		job->failed = FALSE;
-		job->finished = FALSE;
-		g_clear_error (&job->error);
-		
-		ev_render_context_set_page (job_export->rc, ev_page);
-	} else {
-		job_export->rc = ev_render_context_new (ev_page, 0, 1.0);
+
+	job->failed = FALSE;
+	job->finished = FALSE;
+	g_clear_error (&job->error);
+
+	if (job_export->pages->len == 0) {
+		ev_document_doc_mutex_lock ();
+		ev_job_export_do_page (job_export, job_export->page);
+		ev_document_doc_mutex_unlock ();
 	}
-	g_object_unref (ev_page);
-	
-	ev_file_exporter_do_page (EV_FILE_EXPORTER (job->document), job_export->rc);
-	
-	ev_document_doc_mutex_unlock ();
-	
+
+	/* Export the whole run of pages in a single pass through the
+	 * thread, taking the doc mutex per page so that rendering of
+	 * the visible pages can still interleave with the export.
+	 */
+	for (i = 0; i < job_export->pages->len; i++) {
+		EvJobExportPage *page;
+
+		if (g_cancellable_is_cancelled (job->cancellable))
+			break;
+
+		page = &g_array_index (job_export->pages, EvJobExportPage, i);
+
+		ev_document_doc_mutex_lock ();
+		if (page->begin_sheet)
+			ev_file_exporter_begin_page (EV_FILE_EXPORTER (job->document));
+		ev_job_export_do_page (job_export, page->page);
+		if (page->end_sheet)
+			ev_file_exporter_end_page (EV_FILE_EXPORTER (job->document));
+		ev_document_doc_mutex_unlock ();
+	}
+	g_array_set_size (job_export->pages, 0);
+
 	ev_job_succeeded (job);
-	
+
 	return FALSE;
 }
 
@@ -2279,6 +2971,68 @@ ev_job_export_set_page (EvJobExport *job,
 	job->page = page;
 }
 
+/**
+ * ev_job_export_add_page:
+ * @job: an #EvJobExport
+ * @page: the page to export
+ * @begin_sheet: whether to begin a new sheet before exporting @page
+ * @end_sheet: whether to end the current sheet after exporting @page
+ *
+ * Queues @page to be exported the next time @job runs. All the queued
+ * pages are exported in order by a single run of the job, which avoids
+ * going through the main loop for every page.
+ *
+ * Since: 43
+ */
+void
+ev_job_export_add_page (EvJobExport *job,
+			gint         page,
+			gboolean     begin_sheet,
+			gboolean     end_sheet)
+{
+	EvJobExportPage export_page;
+
+	g_return_if_fail (EV_IS_JOB_EXPORT (job));
+
+	export_page.page = page;
+	export_page.begin_sheet = begin_sheet;
+	export_page.end_sheet = end_sheet;
+	g_array_append_val (job->pages, export_page);
+}
+
+/**
+ * ev_job_export_end_sheet:
+ * @job: an #EvJobExport
+ *
+ * Ends the current sheet after the last queued page.
+ *
+ * Since: 43
+ */
+void
+ev_job_export_end_sheet (EvJobExport *job)
+{
+	g_return_if_fail (EV_IS_JOB_EXPORT (job));
+	g_return_if_fail (job->pages->len > 0);
+
+	g_array_index (job->pages, EvJobExportPage, job->pages->len - 1).end_sheet = TRUE;
+}
+
+/**
+ * ev_job_export_has_pages:
+ * @job: an #EvJobExport
+ *
+ * Returns: %TRUE if there are pages queued with ev_job_export_add_page()
+ *
+ * Since: 43
+ */
+gboolean
+ev_job_export_has_pages (EvJobExport *job)
+{
+	g_return_val_if_fail (EV_IS_JOB_EXPORT (job), FALSE);
+
+	return job->pages->len > 0;
+}
+
 /* EvJobPrint */
 static void
 ev_job_print_init (EvJobPrint *job)
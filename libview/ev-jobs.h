@@ -243,6 +243,7 @@ struct _EvJobLinks
 	EvJob parent;
 
 	GtkTreeModel *model;
+	GTree        *page_link_tree;
 };
 
 struct _EvJobLinksClass
@@ -267,11 +268,19 @@ struct _EvJobAnnots
 	EvJob parent;
 
 	GList *annots;
+
+	gint   n_scanned_pages;
+	GMutex mutex;
+	GList *new_annots;
+	guint  updated_idle_id;
 };
 
 struct _EvJobAnnotsClass
 {
 	EvJobClass parent_class;
+
+	/* Signals */
+	void (* updated) (EvJobAnnots *job);
 };
 
 struct _EvJobRender
@@ -287,6 +296,9 @@ struct _EvJobRender
 	gint target_height;
 	cairo_surface_t *surface;
 
+	gboolean has_region;
+	cairo_rectangle_int_t region;
+
 	gboolean include_selection;
 	cairo_surface_t *selection;
 	cairo_region_t *selection_region;
@@ -294,6 +306,9 @@ struct _EvJobRender
 	EvSelectionStyle selection_style;
 	GdkColor base;
 	GdkColor text;
+
+	EvRenderContext *rc;
+	gboolean worker_done;
 };
 
 struct _EvJobRenderClass
@@ -373,6 +388,11 @@ struct _EvJobFonts
 {
 	EvJob parent;
 	gboolean scan_completed;
+
+	GMutex     mutex;
+	GPtrArray *fonts;
+	gdouble    progress;
+	guint      updated_idle_id;
 };
 
 struct _EvJobFontsClass
@@ -390,6 +410,7 @@ struct _EvJobLoad
 
 	gchar *uri;
 	gchar *password;
+	EvDocumentLoadFlags flags;
 };
 
 struct _EvJobLoadClass
@@ -494,6 +515,7 @@ struct _EvJobExport
 
 	gint page;
 	EvRenderContext *rc;
+	GArray *pages;
 };
 
 struct _EvJobExportClass
@@ -549,6 +571,8 @@ EV_PUBLIC
 EvJob          *ev_job_links_new          (EvDocument     *document);
 EV_PUBLIC
 GtkTreeModel   *ev_job_links_get_model    (EvJobLinks     *job);
+EV_PUBLIC
+GTree          *ev_job_links_get_page_link_tree (EvJobLinks *job);
 
 /* EvJobAttachments */
 EV_PUBLIC
@@ -561,6 +585,8 @@ EV_PUBLIC
 GType           ev_job_annots_get_type      (void) G_GNUC_CONST;
 EV_PUBLIC
 EvJob          *ev_job_annots_new           (EvDocument     *document);
+EV_PUBLIC
+GList          *ev_job_annots_take_new_annots (EvJobAnnots  *job);
 
 /* EvJobRender */
 EV_PUBLIC
@@ -578,6 +604,9 @@ void     ev_job_render_set_selection_info (EvJobRender     *job,
 					   EvSelectionStyle selection_style,
 					   GdkColor        *text,
 					   GdkColor        *base);
+EV_PUBLIC
+void     ev_job_render_set_region         (EvJobRender                 *job,
+					   const cairo_rectangle_int_t *region);
 /* EvJobPageData */
 EV_PUBLIC
 GType           ev_job_page_data_get_type (void) G_GNUC_CONST;
@@ -611,6 +640,9 @@ EV_PUBLIC
 GType 		ev_job_fonts_get_type 	  (void) G_GNUC_CONST;
 EV_PUBLIC
 EvJob 	       *ev_job_fonts_new 	  (EvDocument      *document);
+EV_PUBLIC
+void            ev_job_fonts_fill_model   (EvJobFonts      *job,
+					   GtkTreeModel    *model);
 
 /* EvJobLoad */
 EV_PUBLIC
@@ -623,6 +655,9 @@ void            ev_job_load_set_uri       (EvJobLoad       *load,
 EV_PUBLIC
 void            ev_job_load_set_password  (EvJobLoad       *job,
 					   const gchar     *password);
+EV_PUBLIC
+void            ev_job_load_set_load_flags (EvJobLoad          *job,
+					    EvDocumentLoadFlags flags);
 
 /* EvJobLoadStream */
 EV_PUBLIC
@@ -734,6 +769,15 @@ EvJob          *ev_job_export_new         (EvDocument     *document);
 EV_PUBLIC
 void            ev_job_export_set_page    (EvJobExport    *job,
 					   gint            page);
+EV_PUBLIC
+void            ev_job_export_add_page    (EvJobExport    *job,
+					   gint            page,
+					   gboolean        begin_sheet,
+					   gboolean        end_sheet);
+EV_PUBLIC
+void            ev_job_export_end_sheet   (EvJobExport    *job);
+EV_PUBLIC
+gboolean        ev_job_export_has_pages   (EvJobExport    *job);
 /* EvJobPrint */
 EV_PUBLIC
 GType           ev_job_print_get_type    (void) G_GNUC_CONST;
@@ -1345,8 +1345,11 @@ page_cached_cb (EvPageCache *cache,
 		gint page,
 		EvPageAccessible *self)
 {
-	if (page == self->priv->page)
-		ev_page_accessible_initialize_children (self);
+	if (page != self->priv->page)
+		return;
+
+	ev_page_accessible_initialize_children (self);
+	g_signal_handlers_disconnect_by_func (cache, page_cached_cb, self);
 }
 
 EvPageAccessible *
@@ -1368,9 +1371,9 @@ ev_page_accessible_new (EvViewAccessible *view_accessible,
 	if (ev_page_cache_is_page_cached (view->page_cache, page))
 		ev_page_accessible_initialize_children (EV_PAGE_ACCESSIBLE (atk_page));
 	else
-		g_signal_connect (view->page_cache, "page-cached",
-				  G_CALLBACK (page_cached_cb),
-				  atk_page);
+		g_signal_connect_object (view->page_cache, "page-cached",
+					 G_CALLBACK (page_cached_cb),
+					 atk_page, 0);
 
         return EV_PAGE_ACCESSIBLE (atk_page);
 }
@@ -1410,3 +1413,34 @@ ev_page_accessible_update_element_state (EvPageAccessible *page_accessible,
 	if (EV_IS_FORM_FIELD_ACCESSIBLE (child))
 		ev_form_field_accessible_update_state (EV_FORM_FIELD_ACCESSIBLE (child));
 }
+
+/* Link, image and form field accessibles point to their page without
+ * holding a reference, so the page must stay alive as long as anybody
+ * else holds one of them.
+ */
+gboolean
+ev_page_accessible_has_children_in_use (EvPageAccessible *page_accessible)
+{
+	EvPageAccessiblePrivate *priv = page_accessible->priv;
+	GHashTableIter iter;
+	gpointer child;
+	gint i;
+
+	if (priv->children) {
+		for (i = 0; i < priv->children->len; i++) {
+			child = g_ptr_array_index (priv->children, i);
+			if (G_OBJECT (child)->ref_count > 1)
+				return TRUE;
+		}
+	}
+
+	if (priv->links) {
+		g_hash_table_iter_init (&iter, priv->links);
+		while (g_hash_table_iter_next (&iter, NULL, &child)) {
+			if (G_OBJECT (child)->ref_count > 1)
+				return TRUE;
+		}
+	}
+
+	return FALSE;
+}
@@ -58,3 +58,4 @@ AtkObject        *ev_page_accessible_get_accessible_for_mapping (EvPageAccessibl
 								 EvMapping        *mapping);
 void              ev_page_accessible_update_element_state (EvPageAccessible *page_accessible,
 							   EvMapping        *mapping);
+gboolean          ev_page_accessible_has_children_in_use  (EvPageAccessible *page_accessible);
@@ -1,6 +1,9 @@
 #include <config.h>
+#include <math.h>
+#include <unistd.h>
 #include "ev-pixbuf-cache.h"
 #include "ev-job-scheduler.h"
+#include "ev-surface-broker.h"
 #include "ev-view-private.h"
 
 typedef enum {
@@ -51,7 +54,20 @@ struct _EvPixbufCache
         ScrollDirection scroll_direction;
 	gboolean inverted_colors;
 
+	/* Scroll speed in pages per second, estimated from the page
+	 * range changes, and the time of the last change.
+	 */
+	gdouble scroll_velocity;
+	gint64  last_range_change;
+
+	/* While zooming, pages that have a surface at any scale are not
+	 * rendered again, the view scales the surface it has instead.
+	 */
+	gboolean zooming;
+
 	gsize max_size;
+	/* Size of the surfaces held by this cache */
+	gsize memory_used;
 
 	/* preload_cache_size is the number of pages prior to the current
 	 * visible area that we cache.  It's normally 1, but could be 2 in the
@@ -89,6 +105,8 @@ static void          job_finished_cb            (EvJob              *job,
 						 EvPixbufCache      *pixbuf_cache);
 static CacheJobInfo *find_job_cache             (EvPixbufCache      *pixbuf_cache,
 						 int                 page);
+static void          dispose_cache_job_info     (CacheJobInfo       *job_info,
+						 gpointer            data);
 static gboolean      new_selection_surface_needed(EvPixbufCache      *pixbuf_cache,
 						  CacheJobInfo       *job_info,
 						  gint                page,
@@ -104,20 +122,172 @@ static gboolean      new_selection_surface_needed(EvPixbufCache      *pixbuf_cac
 	((pixbuf_cache->end_page - pixbuf_cache->start_page) + 1)
 
 #define MAX_PRELOADED_PAGES 3
+/* When scrolling fast we preload the pages the view will reach in the
+ * next PRELOAD_LOOKAHEAD seconds, up to MAX_FAST_PRELOADED_PAGES.
+ */
+#define MAX_FAST_PRELOADED_PAGES 12
+#define PRELOAD_LOOKAHEAD 0.5
+#define FAST_SCROLL_VELOCITY 4.0
+#define SCROLL_VELOCITY_TIMEOUT (G_USEC_PER_SEC / 2)
+
+/* All the pixbuf caches of the process share a memory budget, which is
+ * a fraction of the physical memory. Every cache gets an even share of
+ * it, never more than the max size set by its view, and preloading
+ * also stops when the surfaces of all the caches use the whole budget.
+ * Under memory pressure the shares are temporarily reduced and
+ * preloaded pages are dropped, under critical pressure nothing is
+ * preloaded at all.
+ */
+#define MIN_MEMORY_BUDGET (64 * 1024 * 1024)
+#define MEMORY_BUDGET_RAM_FRACTION 16
+#define MEMORY_PRESSURE_TIMEOUT 30
+
+static GList *pixbuf_caches = NULL;
+static gsize  memory_budget = 0;
+static gsize  memory_used = 0;
+static guint  memory_pressure = 0;
+static guint  memory_pressure_timeout_id = 0;
 
 G_DEFINE_TYPE (EvPixbufCache, ev_pixbuf_cache, G_TYPE_OBJECT)
 
+static gsize
+get_memory_budget (void)
+{
+	if (memory_budget == 0) {
+		guint64 ram = 0;
+
+#if defined (_SC_PHYS_PAGES) && defined (_SC_PAGESIZE)
+		glong n_pages = sysconf (_SC_PHYS_PAGES);
+		glong page_size = sysconf (_SC_PAGESIZE);
+
+		if (n_pages > 0 && page_size > 0)
+			ram = (guint64) n_pages * page_size;
+#endif
+		memory_budget = MAX (MIN_MEMORY_BUDGET,
+				     MIN (ram / MEMORY_BUDGET_RAM_FRACTION, G_MAXSIZE));
+	}
+
+	return memory_budget;
+}
+
+static gsize
+ev_pixbuf_cache_get_max_size (EvPixbufCache *pixbuf_cache)
+{
+	gsize budget, share, used_by_others;
+
+	if (memory_pressure >= 3)
+		return 0;
+
+	budget = get_memory_budget () >> memory_pressure;
+	share = budget / MAX (g_list_length (pixbuf_caches), 1);
+
+	/* Surfaces held by the other caches can exceed their share, for
+	 * instance when they are zoomed in, so the whole budget is
+	 * checked too.
+	 */
+	used_by_others = memory_used - pixbuf_cache->memory_used;
+	if (used_by_others >= budget)
+		return 0;
+
+	return MIN (MIN (pixbuf_cache->max_size >> memory_pressure, share),
+		    budget - used_by_others);
+}
+
+static void
+ev_pixbuf_cache_drop_preloaded (EvPixbufCache *pixbuf_cache)
+{
+	int i;
+
+	for (i = 0; i < pixbuf_cache->preload_cache_size; i++) {
+		dispose_cache_job_info (pixbuf_cache->prev_job + i, pixbuf_cache);
+		dispose_cache_job_info (pixbuf_cache->next_job + i, pixbuf_cache);
+	}
+}
+
+static gboolean
+memory_pressure_timeout_cb (gpointer user_data)
+{
+	memory_pressure = 0;
+	memory_pressure_timeout_id = 0;
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+set_memory_pressure (guint pressure)
+{
+	GList *l;
+
+	if (memory_pressure_timeout_id > 0)
+		g_source_remove (memory_pressure_timeout_id);
+	memory_pressure_timeout_id = g_timeout_add_seconds (MEMORY_PRESSURE_TIMEOUT,
+							    memory_pressure_timeout_cb,
+							    NULL);
+	g_source_set_name_by_id (memory_pressure_timeout_id, "[evince] memory_pressure_timeout_cb");
+
+	memory_pressure = MAX (memory_pressure, pressure);
+	for (l = pixbuf_caches; l; l = g_list_next (l))
+		ev_pixbuf_cache_drop_preloaded (EV_PIXBUF_CACHE (l->data));
+
+	g_debug ("Memory pressure level %u: %" G_GSIZE_FORMAT " bytes used by %u page caches, budget %" G_GSIZE_FORMAT " bytes",
+		 memory_pressure, memory_used, g_list_length (pixbuf_caches),
+		 memory_pressure >= 3 ? 0 : get_memory_budget () >> memory_pressure);
+}
+
+/* Lets the view, or anyone debugging memory use, know how the shared
+ * budget is being used.
+ */
+void
+ev_pixbuf_cache_get_memory_stats (EvPixbufCache            *pixbuf_cache,
+				  EvPixbufCacheMemoryStats *stats)
+{
+	g_return_if_fail (EV_IS_PIXBUF_CACHE (pixbuf_cache));
+	g_return_if_fail (stats != NULL);
+
+	stats->budget = memory_pressure >= 3 ? 0 : get_memory_budget () >> memory_pressure;
+	stats->used = memory_used;
+	stats->n_caches = g_list_length (pixbuf_caches);
+	stats->pressure = memory_pressure;
+	stats->cache_used = pixbuf_cache->memory_used;
+	stats->cache_max_size = ev_pixbuf_cache_get_max_size (pixbuf_cache);
+}
+
+#if GLIB_CHECK_VERSION (2, 64, 0)
+static void
+low_memory_warning_cb (GMemoryMonitor             *monitor,
+		       GMemoryMonitorWarningLevel  level,
+		       gpointer                    user_data)
+{
+	if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+		set_memory_pressure (3);
+	else if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+		set_memory_pressure (2);
+	else
+		set_memory_pressure (1);
+}
+#endif
+
 static void
 ev_pixbuf_cache_init (EvPixbufCache *pixbuf_cache)
 {
 	pixbuf_cache->start_page = -1;
 	pixbuf_cache->end_page = -1;
+
+	pixbuf_caches = g_list_prepend (pixbuf_caches, pixbuf_cache);
 }
 
 static void
 ev_pixbuf_cache_class_init (EvPixbufCacheClass *class)
 {
 	GObjectClass *object_class;
+#if GLIB_CHECK_VERSION (2, 64, 0)
+	GMemoryMonitor *monitor;
+
+	/* Never released, it's shared by all the caches */
+	monitor = g_memory_monitor_dup_default ();
+	g_signal_connect (monitor, "low-memory-warning",
+			  G_CALLBACK (low_memory_warning_cb), NULL);
+#endif
 
 	object_class = G_OBJECT_CLASS (class);
 
@@ -142,6 +312,8 @@ ev_pixbuf_cache_finalize (GObject *object)
 
 	pixbuf_cache = EV_PIXBUF_CACHE (object);
 
+	pixbuf_caches = g_list_remove (pixbuf_caches, pixbuf_cache);
+
 	if (pixbuf_cache->job_list) {
 		g_slice_free1 (sizeof (CacheJobInfo) * pixbuf_cache->job_list_len,
 			       pixbuf_cache->job_list);
@@ -175,6 +347,32 @@ end_job (CacheJobInfo *job_info,
 	job_info->job = NULL;
 }
 
+static gsize
+get_surface_size (cairo_surface_t *surface)
+{
+	return cairo_image_surface_get_stride (surface) * cairo_image_surface_get_height (surface);
+}
+
+static void
+cache_job_info_set_surface (CacheJobInfo    *job_info,
+			    EvPixbufCache   *pixbuf_cache,
+			    cairo_surface_t *surface)
+{
+	if (job_info->surface) {
+		ev_surface_broker_remove_surface (pixbuf_cache->document,
+						  job_info->surface);
+		memory_used -= get_surface_size (job_info->surface);
+		pixbuf_cache->memory_used -= get_surface_size (job_info->surface);
+		cairo_surface_destroy (job_info->surface);
+	}
+
+	job_info->surface = surface ? cairo_surface_reference (surface) : NULL;
+	if (job_info->surface) {
+		memory_used += get_surface_size (job_info->surface);
+		pixbuf_cache->memory_used += get_surface_size (job_info->surface);
+	}
+}
+
 static void
 dispose_cache_job_info (CacheJobInfo *job_info,
 			gpointer      data)
@@ -185,10 +383,8 @@ dispose_cache_job_info (CacheJobInfo *job_info,
 	if (job_info->job)
 		end_job (job_info, data);
 
-	if (job_info->surface) {
-		cairo_surface_destroy (job_info->surface);
-		job_info->surface = NULL;
-	}
+	if (job_info->surface)
+		cache_job_info_set_surface (job_info, EV_PIXBUF_CACHE (data), NULL);
 	if (job_info->region) {
 		cairo_region_destroy (job_info->region);
 		job_info->region = NULL;
@@ -281,14 +477,19 @@ copy_job_to_job_info (EvJobRender   *job_render,
 		      CacheJobInfo  *job_info,
 		      EvPixbufCache *pixbuf_cache)
 {
-	if (job_info->surface) {
-		cairo_surface_destroy (job_info->surface);
-	}
-	job_info->surface = cairo_surface_reference (job_render->surface);
+	cache_job_info_set_surface (job_info, pixbuf_cache, job_render->surface);
 	set_device_scale_on_surface (job_info->surface, job_info->device_scale);
 	if (pixbuf_cache->inverted_colors) {
 		ev_document_misc_invert_surface (job_info->surface);
 	}
+	/* Let thumbnails and link previews downscale this surface
+	 * instead of rendering the page again.
+	 */
+	ev_surface_broker_add_surface (pixbuf_cache->document,
+				       job_render->page,
+				       job_render->rotation,
+				       pixbuf_cache->inverted_colors,
+				       job_info->surface);
 
 	job_info->points_set = FALSE;
 	if (job_render->include_selection) {
@@ -360,7 +561,8 @@ check_job_size_and_unref (EvPixbufCache *pixbuf_cache,
 
 	g_assert (job_info);
 
-	if (job_info->job == NULL)
+	/* A render at a previous scale is still better than nothing */
+	if (job_info->job == NULL || pixbuf_cache->zooming)
 		return;
 
         device_scale = get_device_scale (pixbuf_cache);
@@ -450,6 +652,12 @@ ev_pixbuf_cache_get_page_size (EvPixbufCache *pixbuf_cache,
 	return height * cairo_format_stride_for_width (CAIRO_FORMAT_RGB24, width);
 }
 
+static gboolean
+ev_pixbuf_cache_is_scrolling_fast (EvPixbufCache *pixbuf_cache)
+{
+	return pixbuf_cache->scroll_velocity >= FAST_SCROLL_VELOCITY;
+}
+
 static gint
 ev_pixbuf_cache_get_preload_size (EvPixbufCache *pixbuf_cache,
 				  gint           start_page,
@@ -457,29 +665,44 @@ ev_pixbuf_cache_get_preload_size (EvPixbufCache *pixbuf_cache,
 				  gdouble        scale,
 				  gint           rotation)
 {
-	gsize range_size = 0;
-	gint  new_preload_cache_size = 0;
-	gint  i;
-	guint n_pages = ev_document_get_n_pages (pixbuf_cache->document);
+	gsize    range_size = 0;
+	gsize    max_size = ev_pixbuf_cache_get_max_size (pixbuf_cache);
+	gint     new_preload_cache_size = 0;
+	gint     max_preload_cache_size = MAX_PRELOADED_PAGES;
+	gboolean count_prev = TRUE;
+	gboolean count_next = TRUE;
+	gint     i;
+	guint    n_pages = ev_document_get_n_pages (pixbuf_cache->document);
+
+	/* While scrolling fast the pages behind the view are not rendered,
+	 * so only the pages ahead of it count against the memory limit.
+	 */
+	if (ev_pixbuf_cache_is_scrolling_fast (pixbuf_cache)) {
+		max_preload_cache_size = CLAMP ((gint) ceil (pixbuf_cache->scroll_velocity * PRELOAD_LOOKAHEAD),
+						MAX_PRELOADED_PAGES,
+						MAX_FAST_PRELOADED_PAGES);
+		count_prev = pixbuf_cache->scroll_direction == SCROLL_DIRECTION_UP;
+		count_next = !count_prev;
+	}
 
 	/* Get the size of the current range */
 	for (i = start_page; i <= end_page; i++) {
 		range_size += ev_pixbuf_cache_get_page_size (pixbuf_cache, i, scale, rotation);
 	}
 
-	if (range_size >= pixbuf_cache->max_size)
+	if (range_size >= max_size)
 		return new_preload_cache_size;
 
 	i = 1;
-	while (((start_page - i > 0) || (end_page + i < n_pages)) &&
-	       new_preload_cache_size < MAX_PRELOADED_PAGES) {
+	while (((count_prev && start_page - i > 0) || (count_next && end_page + i < n_pages)) &&
+	       new_preload_cache_size < max_preload_cache_size) {
 		gsize    page_size;
 		gboolean updated = FALSE;
 
-		if (end_page + i < n_pages) {
+		if (count_next && end_page + i < n_pages) {
 			page_size = ev_pixbuf_cache_get_page_size (pixbuf_cache, end_page + i,
 								   scale, rotation);
-			if (page_size + range_size <= pixbuf_cache->max_size) {
+			if (page_size + range_size <= max_size) {
 				range_size += page_size;
 				new_preload_cache_size++;
 				updated = TRUE;
@@ -488,10 +711,10 @@ ev_pixbuf_cache_get_preload_size (EvPixbufCache *pixbuf_cache,
 			}
 		}
 
-		if (start_page - i > 0) {
+		if (count_prev && start_page - i > 0) {
 			page_size = ev_pixbuf_cache_get_page_size (pixbuf_cache, start_page - i,
 								   scale, rotation);
-			if (page_size + range_size <= pixbuf_cache->max_size) {
+			if (page_size + range_size <= max_size) {
 				range_size += page_size;
 				if (!updated)
 					new_preload_cache_size++;
@@ -710,6 +933,56 @@ add_job (EvPixbufCache  *pixbuf_cache,
 	ev_job_scheduler_push_job (job_info->job, priority);
 }
 
+/* Other views of the document, like the ones of other windows showing
+ * it, share the pages they rendered. When one of them has @page at the
+ * size needed, it's copied instead of being rendered again.
+ */
+static gboolean
+copy_shared_surface (EvPixbufCache *pixbuf_cache,
+		     CacheJobInfo  *job_info,
+		     gint           page,
+		     gint           rotation,
+		     gfloat         scale,
+		     gint           width,
+		     gint           height)
+{
+	gint             device_scale = get_device_scale (pixbuf_cache);
+	cairo_surface_t *surface;
+
+	if (new_selection_surface_needed (pixbuf_cache, job_info, page, scale))
+		return FALSE;
+
+	surface = ev_surface_broker_copy_surface (pixbuf_cache->document,
+						  page, rotation,
+						  width * device_scale,
+						  height * device_scale);
+	if (!surface)
+		return FALSE;
+
+	job_info->device_scale = device_scale;
+	if (job_info->region) {
+		cairo_region_destroy (job_info->region);
+		job_info->region = NULL;
+	}
+
+	cache_job_info_set_surface (job_info, pixbuf_cache, surface);
+	cairo_surface_destroy (surface);
+	set_device_scale_on_surface (job_info->surface, job_info->device_scale);
+	if (pixbuf_cache->inverted_colors)
+		ev_document_misc_invert_surface (job_info->surface);
+	ev_surface_broker_add_surface (pixbuf_cache->document,
+				       page, rotation,
+				       pixbuf_cache->inverted_colors,
+				       job_info->surface);
+
+	job_info->points_set = FALSE;
+	job_info->page_ready = TRUE;
+
+	g_signal_emit (pixbuf_cache, signals[JOB_FINISHED], 0, NULL);
+
+	return TRUE;
+}
+
 static void
 add_job_if_needed (EvPixbufCache *pixbuf_cache,
 		   CacheJobInfo  *job_info,
@@ -721,7 +994,13 @@ add_job_if_needed (EvPixbufCache *pixbuf_cache,
 	gint device_scale = get_device_scale (pixbuf_cache);
 	gint width, height;
 
-	if (job_info->job)
+	if (job_info->job) {
+		if (priority == EV_JOB_PRIORITY_HIGH)
+			ev_job_scheduler_update_job (job_info->job, priority);
+		return;
+	}
+
+	if (job_info->surface && pixbuf_cache->zooming)
 		return;
 
 	_get_page_size_for_scale_and_rotation (pixbuf_cache->document,
@@ -736,10 +1015,8 @@ add_job_if_needed (EvPixbufCache *pixbuf_cache,
 
 	/* Free old surfaces for non visible pages */
 	if (priority == EV_JOB_PRIORITY_LOW) {
-		if (job_info->surface) {
-			cairo_surface_destroy (job_info->surface);
-			job_info->surface = NULL;
-		}
+		if (job_info->surface)
+			cache_job_info_set_surface (job_info, pixbuf_cache, NULL);
 
 		if (job_info->selection) {
 			cairo_surface_destroy (job_info->selection);
@@ -747,6 +1024,10 @@ add_job_if_needed (EvPixbufCache *pixbuf_cache,
 		}
 	}
 
+	if (copy_shared_surface (pixbuf_cache, job_info, page, rotation, scale,
+				 width, height))
+		return;
+
 	add_job (pixbuf_cache, job_info, NULL,
 		 width, height, page, rotation, scale,
 		 priority);
@@ -755,7 +1036,8 @@ add_job_if_needed (EvPixbufCache *pixbuf_cache,
 static void
 add_prev_jobs_if_needed (EvPixbufCache *pixbuf_cache,
                          gint           rotation,
-                         gfloat         scale)
+                         gfloat         scale,
+                         EvJobPriority  priority)
 {
         CacheJobInfo *job_info;
         int page;
@@ -767,14 +1049,15 @@ add_prev_jobs_if_needed (EvPixbufCache *pixbuf_cache,
 
                 add_job_if_needed (pixbuf_cache, job_info,
                                    page, rotation, scale,
-                                   EV_JOB_PRIORITY_LOW);
+                                   priority);
         }
 }
 
 static void
 add_next_jobs_if_needed (EvPixbufCache *pixbuf_cache,
                          gint           rotation,
-                         gfloat         scale)
+                         gfloat         scale,
+                         EvJobPriority  priority)
 {
         CacheJobInfo *job_info;
         int page;
@@ -786,7 +1069,47 @@ add_next_jobs_if_needed (EvPixbufCache *pixbuf_cache,
 
                 add_job_if_needed (pixbuf_cache, job_info,
                                    page, rotation, scale,
-                                   EV_JOB_PRIORITY_LOW);
+                                   priority);
+        }
+}
+
+/* Pages the view has just scrolled past are unlikely to be shown again
+ * soon while scrolling fast, so their pending renders are cancelled to
+ * leave the render thread to the pages ahead. Already rendered pages
+ * close to the view are kept in case the user stops scrolling there.
+ */
+static void
+cancel_trailing_job (EvPixbufCache *pixbuf_cache,
+                     CacheJobInfo  *job_info,
+                     gint           distance)
+{
+        if (distance > MAX_PRELOADED_PAGES)
+                dispose_cache_job_info (job_info, pixbuf_cache);
+        else if (job_info->job)
+                end_job (job_info, pixbuf_cache);
+}
+
+static void
+cancel_prev_jobs (EvPixbufCache *pixbuf_cache)
+{
+        int i;
+
+        for (i = 0; i < pixbuf_cache->preload_cache_size; i++) {
+                cancel_trailing_job (pixbuf_cache,
+                                     pixbuf_cache->prev_job + i,
+                                     pixbuf_cache->preload_cache_size - i);
+        }
+}
+
+static void
+cancel_next_jobs (EvPixbufCache *pixbuf_cache)
+{
+        int i;
+
+        for (i = 0; i < pixbuf_cache->preload_cache_size; i++) {
+                cancel_trailing_job (pixbuf_cache,
+                                     pixbuf_cache->next_job + i,
+                                     i + 1);
         }
 }
 
@@ -808,13 +1131,58 @@ ev_pixbuf_cache_add_jobs_if_needed (EvPixbufCache *pixbuf_cache,
 				   EV_JOB_PRIORITY_URGENT);
 	}
 
-        if (pixbuf_cache->scroll_direction == SCROLL_DIRECTION_UP) {
-                add_prev_jobs_if_needed (pixbuf_cache, rotation, scale);
-                add_next_jobs_if_needed (pixbuf_cache, rotation, scale);
+        if (ev_pixbuf_cache_is_scrolling_fast (pixbuf_cache)) {
+                /* Render the pages ahead right after the visible ones,
+                 * before any other lower priority job.
+                 */
+                if (pixbuf_cache->scroll_direction == SCROLL_DIRECTION_UP) {
+                        add_prev_jobs_if_needed (pixbuf_cache, rotation, scale, EV_JOB_PRIORITY_HIGH);
+                        cancel_next_jobs (pixbuf_cache);
+                } else {
+                        add_next_jobs_if_needed (pixbuf_cache, rotation, scale, EV_JOB_PRIORITY_HIGH);
+                        cancel_prev_jobs (pixbuf_cache);
+                }
+        } else if (pixbuf_cache->scroll_direction == SCROLL_DIRECTION_UP) {
+                add_prev_jobs_if_needed (pixbuf_cache, rotation, scale, EV_JOB_PRIORITY_LOW);
+                add_next_jobs_if_needed (pixbuf_cache, rotation, scale, EV_JOB_PRIORITY_LOW);
+        } else {
+                add_next_jobs_if_needed (pixbuf_cache, rotation, scale, EV_JOB_PRIORITY_LOW);
+                add_prev_jobs_if_needed (pixbuf_cache, rotation, scale, EV_JOB_PRIORITY_LOW);
+        }
+}
+
+static void
+ev_pixbuf_cache_update_scroll_velocity (EvPixbufCache *pixbuf_cache,
+                                        gint           start_page)
+{
+        gint64 now = g_get_monotonic_time ();
+        gint64 elapsed = now - pixbuf_cache->last_range_change;
+        gint   delta;
+
+        if (pixbuf_cache->start_page == -1 || start_page == pixbuf_cache->start_page) {
+                /* The view stopped, or is moving slower than a page
+                 * every SCROLL_VELOCITY_TIMEOUT.
+                 */
+                if (elapsed > SCROLL_VELOCITY_TIMEOUT)
+                        pixbuf_cache->scroll_velocity = 0;
+                return;
+        }
+
+        delta = ABS (start_page - pixbuf_cache->start_page);
+
+        /* Jumps, like following a link, are not scrolling */
+        if (elapsed > SCROLL_VELOCITY_TIMEOUT || delta > MAX_FAST_PRELOADED_PAGES) {
+                pixbuf_cache->scroll_velocity = 0;
         } else {
-                add_next_jobs_if_needed (pixbuf_cache, rotation, scale);
-                add_prev_jobs_if_needed (pixbuf_cache, rotation, scale);
+                gdouble velocity;
+
+                /* Smooth out the estimate, range changes don't happen at
+                 * a regular pace.
+                 */
+                velocity = (gdouble) delta * G_USEC_PER_SEC / MAX (elapsed, 1);
+                pixbuf_cache->scroll_velocity = (pixbuf_cache->scroll_velocity + velocity) / 2;
         }
+        pixbuf_cache->last_range_change = now;
 }
 
 static ScrollDirection
@@ -852,6 +1220,7 @@ ev_pixbuf_cache_set_page_range (EvPixbufCache  *pixbuf_cache,
 	g_return_if_fail (end_page >= 0 && end_page < ev_document_get_n_pages (pixbuf_cache->document));
 	g_return_if_fail (end_page >= start_page);
 
+        ev_pixbuf_cache_update_scroll_velocity (pixbuf_cache, start_page);
         pixbuf_cache->scroll_direction = ev_pixbuf_cache_get_scroll_direction (pixbuf_cache, start_page, end_page);
 
 	/* First, resize the page_range as needed.  We cull old pages
@@ -870,6 +1239,18 @@ ev_pixbuf_cache_set_page_range (EvPixbufCache  *pixbuf_cache,
 	ev_pixbuf_cache_add_jobs_if_needed (pixbuf_cache, rotation, scale);
 }
 
+/* Call with @zooming %TRUE while the scale is changing continuously,
+ * like during a pinch zoom, to avoid rendering every intermediate
+ * scale. Once it's set back to %FALSE, the next page range update
+ * renders the pages at the final scale.
+ */
+void
+ev_pixbuf_cache_set_zooming (EvPixbufCache *pixbuf_cache,
+			     gboolean       zooming)
+{
+	pixbuf_cache->zooming = zooming;
+}
+
 void
 ev_pixbuf_cache_set_inverted_colors (EvPixbufCache *pixbuf_cache,
 				     gboolean       inverted_colors)
@@ -886,11 +1267,13 @@ ev_pixbuf_cache_set_inverted_colors (EvPixbufCache *pixbuf_cache,
 
 		job_info = pixbuf_cache->prev_job + i;
 		if (job_info && job_info->surface)
-			ev_document_misc_invert_surface (job_info->surface);
+			ev_surface_broker_invert_surface (pixbuf_cache->document,
+							  job_info->surface);
 
 		job_info = pixbuf_cache->next_job + i;
 		if (job_info && job_info->surface)
-			ev_document_misc_invert_surface (job_info->surface);
+			ev_surface_broker_invert_surface (pixbuf_cache->document,
+							  job_info->surface);
 	}
 
 	for (i = 0; i < PAGE_CACHE_LEN (pixbuf_cache); i++) {
@@ -898,7 +1281,8 @@ ev_pixbuf_cache_set_inverted_colors (EvPixbufCache *pixbuf_cache,
 
 		job_info = pixbuf_cache->job_list + i;
 		if (job_info && job_info->surface)
-			ev_document_misc_invert_surface (job_info->surface);
+			ev_surface_broker_invert_surface (pixbuf_cache->document,
+							  job_info->surface);
 	}
 }
 
@@ -975,6 +1359,79 @@ clear_selection_region_if_needed (EvPixbufCache *pixbuf_cache,
 	}
 }
 
+static void
+reload_job_info (EvPixbufCache *pixbuf_cache,
+		 CacheJobInfo  *job_info,
+		 gint           page,
+		 EvDocument    *document)
+{
+	gchar *old_fingerprint = NULL;
+	gchar *new_fingerprint = NULL;
+
+	if (job_info->surface && page >= 0 && page < ev_document_get_n_pages (document)) {
+		old_fingerprint = ev_document_get_page_fingerprint (pixbuf_cache->document, page);
+		if (old_fingerprint)
+			new_fingerprint = ev_document_get_page_fingerprint (document, page);
+	}
+
+	if (!old_fingerprint || g_strcmp0 (old_fingerprint, new_fingerprint) != 0) {
+		dispose_cache_job_info (job_info, pixbuf_cache);
+	} else {
+		/* Keep the surface, but not what belongs to the old document,
+		 * and share it for the new one.
+		 */
+		if (job_info->job)
+			end_job (job_info, pixbuf_cache);
+		ev_surface_broker_remove_surface (pixbuf_cache->document, job_info->surface);
+		ev_surface_broker_add_surface (document, page,
+					       ev_document_model_get_rotation (pixbuf_cache->model),
+					       pixbuf_cache->inverted_colors,
+					       job_info->surface);
+		g_clear_pointer (&job_info->region, cairo_region_destroy);
+		g_clear_pointer (&job_info->selection, cairo_surface_destroy);
+		g_clear_pointer (&job_info->selection_region, cairo_region_destroy);
+		job_info->points_set = FALSE;
+	}
+
+	g_free (old_fingerprint);
+	g_free (new_fingerprint);
+}
+
+/**
+ * ev_pixbuf_cache_reload_document:
+ * @pixbuf_cache: an #EvPixbufCache
+ * @document: the new document
+ *
+ * Switches @pixbuf_cache to @document, typically the same file loaded
+ * again after it changed on disk. The rendered pages whose fingerprint
+ * didn't change are kept, everything else is dropped.
+ */
+void
+ev_pixbuf_cache_reload_document (EvPixbufCache *pixbuf_cache,
+				 EvDocument    *document)
+{
+	int i;
+
+	if (pixbuf_cache->job_list) {
+		for (i = 0; i < pixbuf_cache->preload_cache_size; i++) {
+			reload_job_info (pixbuf_cache, pixbuf_cache->prev_job + i,
+					 pixbuf_cache->start_page - pixbuf_cache->preload_cache_size + i,
+					 document);
+			reload_job_info (pixbuf_cache, pixbuf_cache->next_job + i,
+					 pixbuf_cache->end_page + 1 + i,
+					 document);
+		}
+
+		for (i = 0; i < PAGE_CACHE_LEN (pixbuf_cache); i++) {
+			reload_job_info (pixbuf_cache, pixbuf_cache->job_list + i,
+					 pixbuf_cache->start_page + i,
+					 document);
+		}
+	}
+
+	pixbuf_cache->document = document;
+}
+
 /* Clears the cache of jobs and pixbufs.
  */
 void
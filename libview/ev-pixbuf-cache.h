@@ -55,6 +55,16 @@ struct _EvViewSelection {
 typedef struct _EvPixbufCache       EvPixbufCache;
 typedef struct _EvPixbufCacheClass  EvPixbufCacheClass;
 
+/* Memory used by the surfaces of the pixbuf caches, in bytes */
+typedef struct {
+	gsize budget;         /* Shared by all the caches, 0 under critical pressure */
+	gsize used;           /* By all the caches */
+	guint n_caches;
+	guint pressure;       /* 0 (none) to 3 (critical) */
+	gsize cache_used;     /* By this cache */
+	gsize cache_max_size; /* What this cache can use right now */
+} EvPixbufCacheMemoryStats;
+
 GType          ev_pixbuf_cache_get_type             (void) G_GNUC_CONST;
 EvPixbufCache *ev_pixbuf_cache_new                  (GtkWidget     *view,
 						     EvDocumentModel *model,
@@ -68,6 +78,8 @@ void           ev_pixbuf_cache_set_page_range       (EvPixbufCache *pixbuf_cache
 cairo_surface_t *ev_pixbuf_cache_get_surface        (EvPixbufCache *pixbuf_cache,
 						     gint           page);
 void           ev_pixbuf_cache_clear                (EvPixbufCache *pixbuf_cache);
+void           ev_pixbuf_cache_reload_document      (EvPixbufCache *pixbuf_cache,
+						     EvDocument    *document);
 void           ev_pixbuf_cache_style_changed        (EvPixbufCache *pixbuf_cache);
 void           ev_pixbuf_cache_reload_page 	    (EvPixbufCache  *pixbuf_cache,
 						     cairo_region_t *region,
@@ -76,6 +88,10 @@ void           ev_pixbuf_cache_reload_page 	    (EvPixbufCache  *pixbuf_cache,
 						     gdouble         scale);
 void           ev_pixbuf_cache_set_inverted_colors  (EvPixbufCache *pixbuf_cache,
 						     gboolean       inverted_colors);
+void           ev_pixbuf_cache_set_zooming          (EvPixbufCache *pixbuf_cache,
+						     gboolean       zooming);
+void           ev_pixbuf_cache_get_memory_stats     (EvPixbufCache            *pixbuf_cache,
+						     EvPixbufCacheMemoryStats *stats);
 /* Selection */
 cairo_surface_t *ev_pixbuf_cache_get_selection_surface (EvPixbufCache   *pixbuf_cache,
 							gint             page,
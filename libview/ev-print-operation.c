@@ -25,6 +25,8 @@
 
 #include <glib/gi18n.h>
 #include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "ev-jobs.h"
@@ -375,6 +377,8 @@ ev_print_operation_update_status (EvPrintOperation *op,
 }
 
 /* Export interface */
+#define EXPORT_PAGES_PER_JOB 16
+
 #define EV_TYPE_PRINT_OPERATION_EXPORT            (ev_print_operation_export_get_type())
 #define EV_PRINT_OPERATION_EXPORT(object)         (G_TYPE_CHECK_INSTANCE_CAST((object), EV_TYPE_PRINT_OPERATION_EXPORT, EvPrintOperationExport))
 #define EV_PRINT_OPERATION_EXPORT_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass), EV_TYPE_PRINT_OPERATION_EXPORT, EvPrintOperationExportClass))
@@ -390,6 +394,7 @@ static GType    ev_print_operation_export_get_type (void) G_GNUC_CONST;
 static void     ev_print_operation_export_begin    (EvPrintOperationExport *export);
 static gboolean export_print_page                  (EvPrintOperationExport *export);
 static void     export_cancel                      (EvPrintOperationExport *export);
+static void     update_progress                    (EvPrintOperationExport *export);
 
 struct _EvPrintOperationExport {
 	EvPrintOperation parent;
@@ -408,7 +413,9 @@ struct _EvPrintOperationExport {
 	gint pages_per_sheet;
 	gint fd;
 	gchar *temp_file;
+	gchar *output_file;
 	gchar *job_name;
+	gboolean direct_output;
 	gboolean embed_page_setup;
 
 	guint idle_id;
@@ -427,6 +434,7 @@ struct _EvPrintOperationExport {
 	GtkPageRange one_range;
 
 	gint page, start, end, inc;
+	gboolean last_batch;
 };
 
 struct _EvPrintOperationExportClass {
@@ -730,6 +738,24 @@ get_first_and_last_page (EvPrintOperationExport *export,
 	*last = MIN (max_page, last_page);
 }
 
+static void
+export_print_end_sheet (EvPrintOperationExport *export)
+{
+	EvPrintOperation *op = EV_PRINT_OPERATION (export);
+
+	/* End the sheet after the last queued page, or right away
+	 * if it was already exported by a previous run of the job.
+	 */
+	if (export->job_export &&
+	    ev_job_export_has_pages (EV_JOB_EXPORT (export->job_export))) {
+		ev_job_export_end_sheet (EV_JOB_EXPORT (export->job_export));
+	} else {
+		ev_document_doc_mutex_lock ();
+		ev_file_exporter_end_page (EV_FILE_EXPORTER (op->document));
+		ev_document_doc_mutex_unlock ();
+	}
+}
+
 static gboolean
 export_print_inc_page (EvPrintOperationExport *export)
 {
@@ -753,9 +779,6 @@ export_print_inc_page (EvPrintOperationExport *export)
 				if (export->pages_per_sheet > 1 && export->collate == 1 &&
 				    (export->page_count - 1) % export->pages_per_sheet != 0) {
 
-					EvPrintOperation *op = EV_PRINT_OPERATION (export);
-					ev_document_doc_mutex_lock ();
-
 					/* keep track of all blanks but only actualise those
 					 * which are in the current odd / even sheet set */
 
@@ -763,9 +786,8 @@ export_print_inc_page (EvPrintOperationExport *export)
 					if (export->page_set == GTK_PAGE_SET_ALL ||
 						(export->page_set == GTK_PAGE_SET_EVEN && export->sheet % 2 == 0) ||
 						(export->page_set == GTK_PAGE_SET_ODD && export->sheet % 2 == 1) ) {
-						ev_file_exporter_end_page (EV_FILE_EXPORTER (op->document));
+						export_print_end_sheet (export);
 					}
-					ev_document_doc_mutex_unlock ();
 					export->sheet = 1 + (export->page_count - 1) / export->pages_per_sheet;
 				}
 
@@ -824,6 +846,34 @@ export_print_done (EvPrintOperationExport *export)
 
 	g_assert (export->temp_file != NULL);
 
+	if (export->direct_output) {
+		/* The pages were exported next to the output file, which
+		 * is only replaced now that the export is complete.
+		 */
+		if (export->fd != -1) {
+			close (export->fd);
+			export->fd = -1;
+		}
+
+		if (g_rename (export->temp_file, export->output_file) < 0) {
+			int errsv = errno;
+
+			g_set_error (&export->error,
+				     GTK_PRINT_ERROR,
+				     GTK_PRINT_ERROR_GENERAL,
+				     _("Failed to save “%s”: %s"),
+				     export->output_file, g_strerror (errsv));
+			ev_print_operation_export_clear_temp_file (export);
+			g_signal_emit (op, signals[DONE], 0, GTK_PRINT_OPERATION_RESULT_ERROR);
+		} else {
+			g_clear_pointer (&export->temp_file, g_free);
+			g_signal_emit (op, signals[DONE], 0, GTK_PRINT_OPERATION_RESULT_APPLY);
+		}
+
+		ev_print_operation_export_run_next (export);
+		return;
+	}
+
 	/* Some printers take into account some print settings,
 	 * and others don't. However we have exported the document
 	 * to a ps or pdf file according to such print settings. So,
@@ -877,20 +927,27 @@ export_print_page_idle_finished (EvPrintOperationExport *export)
 }
 
 static void
-export_job_finished (EvJobExport            *job,
-		     EvPrintOperationExport *export)
+export_print_end (EvPrintOperationExport *export)
 {
 	EvPrintOperation *op = EV_PRINT_OPERATION (export);
 
-	if (export->pages_per_sheet == 1 ||
-	   ( export->page_count % export->pages_per_sheet == 0 &&
-	   ( export->page_set == GTK_PAGE_SET_ALL ||
-	   ( export->page_set == GTK_PAGE_SET_EVEN && export->sheet % 2 == 0 ) ||
-	   ( export->page_set == GTK_PAGE_SET_ODD && export->sheet % 2 == 1 ) ) ) ) {
+	ev_document_doc_mutex_lock ();
+	ev_file_exporter_end (EV_FILE_EXPORTER (op->document));
+	ev_document_doc_mutex_unlock ();
 
-		ev_document_doc_mutex_lock ();
-		ev_file_exporter_end_page (EV_FILE_EXPORTER (op->document));
-		ev_document_doc_mutex_unlock ();
+	update_progress (export);
+	export_print_done (export);
+}
+
+static void
+export_job_finished (EvJobExport            *job,
+		     EvPrintOperationExport *export)
+{
+	update_progress (export);
+
+	if (export->last_batch) {
+		export_print_end (export);
+		return;
 	}
 
 	/* Reschedule */
@@ -949,14 +1006,12 @@ update_progress (EvPrintOperationExport *export)
 					  export->total / (gdouble)export->n_pages_to_print);
 }
 
+/* Advances to the next page to export, returns FALSE when
+ * all the pages have been exported.
+ */
 static gboolean
-export_print_page (EvPrintOperationExport *export)
+export_print_next_page (EvPrintOperationExport *export)
 {
-	EvPrintOperation *op = EV_PRINT_OPERATION (export);
-
-	if (!export->temp_file)
-		return FALSE; /* cancelled */
-
 	export->total++;
 	export->collated++;
 
@@ -968,16 +1023,8 @@ export_print_page (EvPrintOperationExport *export)
 
 	if (export->collated == export->collated_copies) {
 		export->collated = 0;
-		if (!export_print_inc_page (export)) {
-			ev_document_doc_mutex_lock ();
-			ev_file_exporter_end (EV_FILE_EXPORTER (op->document));
-			ev_document_doc_mutex_unlock ();
-
-			update_progress (export);
-			export_print_done (export);
-
+		if (!export_print_inc_page (export))
 			return FALSE;
-		}
 	}
 
 	/* we're not collating and we've reached a sheet from the wrong sheet set */
@@ -993,16 +1040,8 @@ export_print_page (EvPrintOperationExport *export)
 			if (export->collated == export->collated_copies) {
 				export->collated = 0;
 
-				if (!export_print_inc_page (export)) {
-					ev_document_doc_mutex_lock ();
-					ev_file_exporter_end (EV_FILE_EXPORTER (op->document));
-					ev_document_doc_mutex_unlock ();
-
-					update_progress (export);
-
-					export_print_done (export);
+				if (!export_print_inc_page (export))
 					return FALSE;
-				}
 			}
 
 		} while ((export->page_set == GTK_PAGE_SET_EVEN && export->sheet % 2 != 0) ||
@@ -1010,15 +1049,19 @@ export_print_page (EvPrintOperationExport *export)
 
 	}
 
-	if (export->pages_per_sheet == 1 ||
-	    (export->page_count % export->pages_per_sheet == 1 &&
-	    (export->page_set == GTK_PAGE_SET_ALL ||
-	    (export->page_set == GTK_PAGE_SET_EVEN && export->sheet % 2 == 0) ||
-	    (export->page_set == GTK_PAGE_SET_ODD && export->sheet % 2 == 1)))) {
-		ev_document_doc_mutex_lock ();
-		ev_file_exporter_begin_page (EV_FILE_EXPORTER (op->document));
-		ev_document_doc_mutex_unlock ();
-	}
+	return TRUE;
+}
+
+static gboolean
+export_print_page (EvPrintOperationExport *export)
+{
+	EvPrintOperation *op = EV_PRINT_OPERATION (export);
+	EvJobExport      *job;
+	gint              n_pages;
+	gboolean          begin_sheet, end_sheet;
+
+	if (!export->temp_file)
+		return FALSE; /* cancelled */
 
 	if (!export->job_export) {
 		export->job_export = ev_job_export_new (op->document);
@@ -1029,11 +1072,37 @@ export_print_page (EvPrintOperationExport *export)
 				  G_CALLBACK (export_job_cancelled),
 				  (gpointer)export);
 	}
+	job = EV_JOB_EXPORT (export->job_export);
 
-	ev_job_export_set_page (EV_JOB_EXPORT (export->job_export), export->page);
-	ev_job_scheduler_push_job (export->job_export, EV_JOB_PRIORITY_NONE);
+	/* Queue a run of pages so that the export job goes through
+	 * them in one pass, instead of a main loop iteration per page.
+	 */
+	for (n_pages = 0; n_pages < EXPORT_PAGES_PER_JOB; n_pages++) {
+		if (!export_print_next_page (export)) {
+			export->last_batch = TRUE;
+			break;
+		}
 
-	update_progress (export);
+		begin_sheet = export->pages_per_sheet == 1 ||
+			(export->page_count % export->pages_per_sheet == 1 &&
+			 (export->page_set == GTK_PAGE_SET_ALL ||
+			  (export->page_set == GTK_PAGE_SET_EVEN && export->sheet % 2 == 0) ||
+			  (export->page_set == GTK_PAGE_SET_ODD && export->sheet % 2 == 1)));
+		end_sheet = export->pages_per_sheet == 1 ||
+			(export->page_count % export->pages_per_sheet == 0 &&
+			 (export->page_set == GTK_PAGE_SET_ALL ||
+			  (export->page_set == GTK_PAGE_SET_EVEN && export->sheet % 2 == 0) ||
+			  (export->page_set == GTK_PAGE_SET_ODD && export->sheet % 2 == 1)));
+
+		ev_job_export_add_page (job, export->page, begin_sheet, end_sheet);
+	}
+
+	if (!ev_job_export_has_pages (job)) {
+		export_print_end (export);
+		return FALSE;
+	}
+
+	ev_job_scheduler_push_job (export->job_export, EV_JOB_PRIORITY_NONE);
 
 	return FALSE;
 }
@@ -1151,6 +1220,48 @@ ev_print_operation_export_mkstemp (EvPrintOperationExport *export,
         return TRUE;
 }
 
+/* Exports to a temporary file next to @filename instead of one that is
+ * later handed to the print system, so printing to a file doesn't need
+ * a second full copy of the document nor wait for it to be copied. The
+ * temporary file is renamed to @filename once the export succeeds, so
+ * an existing file is left untouched when the export fails or is
+ * cancelled.
+ */
+static gboolean
+ev_print_operation_export_open_output_file (EvPrintOperationExport *export,
+                                            const gchar            *filename)
+{
+        gchar *dirname;
+        gchar *basename;
+        gchar *template;
+
+        dirname = g_path_get_dirname (filename);
+        basename = g_path_get_basename (filename);
+        template = g_strdup_printf (".%s.XXXXXX", basename);
+        export->temp_file = g_build_filename (dirname, template, NULL);
+        g_free (dirname);
+        g_free (basename);
+        g_free (template);
+
+        export->fd = g_mkstemp_full (export->temp_file, O_WRONLY, 0666);
+        if (export->fd == -1) {
+                int errsv = errno;
+
+                g_set_error (&export->error,
+                             GTK_PRINT_ERROR,
+                             GTK_PRINT_ERROR_GENERAL,
+                             _("Failed to open “%s” for writing: %s"),
+                             filename, g_strerror (errsv));
+                g_clear_pointer (&export->temp_file, g_free);
+                return FALSE;
+        }
+
+        export->output_file = g_strdup (filename);
+        export->direct_output = TRUE;
+
+        return TRUE;
+}
+
 static gboolean
 ev_print_operation_export_update_ranges (EvPrintOperationExport *export)
 {
@@ -1291,6 +1402,8 @@ ev_print_operation_export_finalize (GObject *object)
 		export->temp_file = NULL;
 	}
 
+	g_clear_pointer (&export->output_file, g_free);
+
 	if (export->job_name) {
 		g_free (export->job_name);
 		export->job_name = NULL;
@@ -1997,6 +2110,8 @@ export_unix_print_dialog_response_cb (GtkDialog              *dialog,
 	GtkPageSetup         *page_setup;
 	GtkPrinter           *printer;
 	EvFileExporterFormat  format;
+	gchar                *output_file = NULL;
+	gboolean              opened;
 
 	if (response != GTK_RESPONSE_OK &&
 	    response != GTK_RESPONSE_APPLY) {
@@ -2033,13 +2148,6 @@ export_unix_print_dialog_response_cb (GtkDialog              *dialog,
 		return;
 	}
 
-        if (!ev_print_operation_export_mkstemp (export, format)) {
-		gtk_widget_destroy (GTK_WIDGET (dialog));
-
-		g_signal_emit (op, signals[DONE], 0, GTK_PRINT_OPERATION_RESULT_ERROR);
-		return;
-	}
-
         /* FIXMEchpe (why) is this necessary? */
 	export->current_page = gtk_print_unix_dialog_get_current_page (GTK_PRINT_UNIX_DIALOG (dialog));
 
@@ -2062,6 +2170,31 @@ export_unix_print_dialog_response_cb (GtkDialog              *dialog,
 		return;
 	}
 
+	/* Print to file doesn't need to go through a temporary file.
+	 * Outputs are only opened once the ranges are known to be valid,
+	 * since the dialog stays open otherwise.
+	 */
+	if (!op->print_preview && gtk_printer_is_virtual (export_unix->printer)) {
+		const gchar *uri;
+
+		uri = gtk_print_settings_get (print_settings, GTK_PRINT_SETTINGS_OUTPUT_URI);
+		if (uri)
+			output_file = g_filename_from_uri (uri, NULL, NULL);
+	}
+
+	if (output_file)
+		opened = ev_print_operation_export_open_output_file (export, output_file);
+	else
+		opened = ev_print_operation_export_mkstemp (export, format);
+	g_free (output_file);
+
+        if (!opened) {
+		gtk_widget_destroy (GTK_WIDGET (dialog));
+
+		g_signal_emit (op, signals[DONE], 0, GTK_PRINT_OPERATION_RESULT_ERROR);
+		return;
+	}
+
 	gtk_widget_destroy (GTK_WIDGET (dialog));
 
         ev_print_operation_export_prepare (export, format);
@@ -2492,7 +2625,7 @@ print_job_finished (EvJobPrint            *job,
 static gboolean
 draw_page_finish_idle (EvPrintOperationPrint *print)
 {
-        if (ev_job_scheduler_get_running_thread_job () == print->job_print)
+        if (ev_job_scheduler_is_job_running (print->job_print))
                 return TRUE;
 
         gtk_print_operation_draw_page_finish (print->op);
@@ -2509,7 +2642,7 @@ print_job_cancelled (EvJobPrint            *job,
          * print operation. If the job is still
          * running, wait until it finishes.
          */
-        if (ev_job_scheduler_get_running_thread_job () == print->job_print)
+        if (ev_job_scheduler_is_job_running (print->job_print))
                 g_idle_add ((GSourceFunc)draw_page_finish_idle, print);
         else
                 gtk_print_operation_draw_page_finish (print->op);
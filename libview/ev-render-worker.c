@@ -0,0 +1,573 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include <gio/gio.h>
+
+#ifdef G_OS_UNIX
+#include <gio/gunixfdmessage.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ev-debug.h"
+#include "ev-render-worker.h"
+
+#define POOL_DATA_KEY "ev-render-worker-pool"
+
+/* Timeouts in seconds after which a worker is considered stuck and killed */
+#define LOAD_TIMEOUT   60
+#define RENDER_TIMEOUT 30
+
+guint
+ev_render_worker_get_n_workers (void)
+{
+	static gsize n_workers = 0;
+
+	if (g_once_init_enter (&n_workers)) {
+		const gchar *env;
+		guint64      value = 0;
+
+		env = g_getenv ("EV_RENDER_WORKERS");
+		if (env)
+			value = g_ascii_strtoull (env, NULL, 10);
+
+		/* Zero can't be stored, it means the value is not set yet */
+		g_once_init_leave (&n_workers, CLAMP (value, 0, 64) + 1);
+	}
+
+	return n_workers - 1;
+}
+
+#ifdef G_OS_UNIX
+
+typedef struct {
+	GSubprocess *process;
+	GSocket     *socket;
+} EvRenderWorker;
+
+/* Workers are spawned on demand, up to the configured number, and they
+ * are handed out to one render job at a time.
+ */
+typedef struct {
+	GMutex     mutex;
+	GCond      cond;
+	gchar     *uri;
+	gint64     mtime;
+	goffset    size;
+	GPtrArray *idle_workers;
+	guint      n_workers;
+	gboolean   disabled;
+} EvRenderWorkerPool;
+
+static GMutex pools_mutex;
+
+static const cairo_user_data_key_t mapping_key;
+
+typedef struct {
+	gpointer data;
+	gsize    size;
+} Mapping;
+
+static void
+ev_render_worker_free (EvRenderWorker *worker)
+{
+	g_subprocess_force_exit (worker->process);
+	g_object_unref (worker->process);
+	g_socket_close (worker->socket, NULL);
+	g_object_unref (worker->socket);
+	g_free (worker);
+}
+
+static void
+ev_render_worker_pool_free (EvRenderWorkerPool *pool)
+{
+	g_ptr_array_foreach (pool->idle_workers, (GFunc) ev_render_worker_free, NULL);
+	g_ptr_array_free (pool->idle_workers, TRUE);
+	g_free (pool->uri);
+	g_mutex_clear (&pool->mutex);
+	g_cond_clear (&pool->cond);
+	g_free (pool);
+}
+
+static gboolean
+query_file_identity (const gchar *uri,
+		     gint64      *mtime,
+		     goffset     *size)
+{
+	GFile     *file;
+	GFileInfo *info;
+
+	file = g_file_new_for_uri (uri);
+	info = g_file_query_info (file,
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE,
+				  G_FILE_QUERY_INFO_NONE, NULL, NULL);
+	g_object_unref (file);
+	if (!info)
+		return FALSE;
+
+	*mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+		g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+	*size = g_file_info_get_size (info);
+	g_object_unref (info);
+
+	return TRUE;
+}
+
+/* Must be called with pools_mutex held */
+static EvRenderWorkerPool *
+ev_render_worker_pool_new (EvDocument *document,
+			   gboolean    enabled)
+{
+	EvRenderWorkerPool *pool;
+	const gchar        *uri;
+
+	pool = g_new0 (EvRenderWorkerPool, 1);
+	g_mutex_init (&pool->mutex);
+	g_cond_init (&pool->cond);
+	pool->idle_workers = g_ptr_array_new ();
+
+	/* Workers load the document on their own, which is only possible
+	 * for documents loaded from a file, and only while the file is
+	 * still the one the viewer loaded.
+	 */
+	uri = ev_document_get_uri (document);
+	if (enabled && uri && query_file_identity (uri, &pool->mtime, &pool->size))
+		pool->uri = g_strdup (uri);
+	else
+		pool->disabled = TRUE;
+
+	g_object_set_data_full (G_OBJECT (document), POOL_DATA_KEY,
+				pool,
+				(GDestroyNotify) ev_render_worker_pool_free);
+
+	return pool;
+}
+
+static EvRenderWorkerPool *
+ev_render_worker_pool_get (EvDocument *document)
+{
+	EvRenderWorkerPool *pool;
+
+	g_mutex_lock (&pools_mutex);
+
+	/* Documents that were not loaded by ev_render_worker_document_loaded()
+	 * can't be checked against the file the workers would load.
+	 */
+	pool = g_object_get_data (G_OBJECT (document), POOL_DATA_KEY);
+	if (!pool)
+		pool = ev_render_worker_pool_new (document, FALSE);
+
+	g_mutex_unlock (&pools_mutex);
+
+	return pool;
+}
+
+static gboolean
+ev_render_worker_receive_reply (EvRenderWorker      *worker,
+				EvRenderWorkerReply *reply,
+				gint                *fd)
+{
+	GInputVector            vector = { reply, sizeof (EvRenderWorkerReply) };
+	GSocketControlMessage **messages = NULL;
+	gint                    n_messages = 0;
+	gint                    i;
+	gssize                  len;
+	GError                 *error = NULL;
+
+	if (fd)
+		*fd = -1;
+
+	len = g_socket_receive_message (worker->socket, NULL, &vector, 1,
+					&messages, &n_messages, NULL,
+					NULL, &error);
+	if (len < 0) {
+		g_warning ("Failed to receive reply from render worker: %s", error->message);
+		g_error_free (error);
+	}
+
+	for (i = 0; i < n_messages; i++) {
+		if (G_IS_UNIX_FD_MESSAGE (messages[i])) {
+			gint *fds;
+			gint  n_fds, j;
+
+			fds = g_unix_fd_message_steal_fds (G_UNIX_FD_MESSAGE (messages[i]), &n_fds);
+			for (j = 0; j < n_fds; j++) {
+				if (fd && *fd == -1)
+					*fd = fds[j];
+				else
+					close (fds[j]);
+			}
+			g_free (fds);
+		}
+		g_object_unref (messages[i]);
+	}
+	g_free (messages);
+
+	return len == sizeof (EvRenderWorkerReply);
+}
+
+static EvRenderWorker *
+ev_render_worker_spawn (EvRenderWorkerPool *pool,
+			gboolean           *load_failed)
+{
+	GSubprocessLauncher *launcher;
+	EvRenderWorker      *worker;
+	EvRenderWorkerReply  reply;
+	gchar               *path;
+	gchar               *mtime;
+	gchar               *size;
+	gint                 fds[2];
+	GError              *error = NULL;
+
+	*load_failed = FALSE;
+
+	if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+		g_warning ("Failed to create render worker socket: %s", g_strerror (errno));
+		return NULL;
+	}
+
+	worker = g_new0 (EvRenderWorker, 1);
+	worker->socket = g_socket_new_from_fd (fds[0], &error);
+	if (!worker->socket) {
+		g_warning ("Failed to create render worker socket: %s", error->message);
+		g_error_free (error);
+		close (fds[0]);
+		close (fds[1]);
+		g_free (worker);
+
+		return NULL;
+	}
+
+	launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_NONE);
+	g_subprocess_launcher_take_fd (launcher, fds[1], EV_RENDER_WORKER_SOCKET_FD);
+
+	path = g_build_filename (EVINCE_LIBEXECDIR, "evince-render-worker", NULL);
+	mtime = g_strdup_printf ("%" G_GINT64_FORMAT, pool->mtime);
+	size = g_strdup_printf ("%" G_GOFFSET_FORMAT, pool->size);
+	worker->process = g_subprocess_launcher_spawn (launcher, &error,
+						       path, pool->uri, mtime, size,
+						       NULL);
+	g_free (path);
+	g_free (mtime);
+	g_free (size);
+	g_object_unref (launcher);
+
+	if (!worker->process) {
+		g_warning ("Failed to spawn render worker: %s", error->message);
+		g_error_free (error);
+		g_socket_close (worker->socket, NULL);
+		g_object_unref (worker->socket);
+		g_free (worker);
+		*load_failed = TRUE;
+
+		return NULL;
+	}
+
+	g_socket_set_timeout (worker->socket, LOAD_TIMEOUT);
+	if (!ev_render_worker_receive_reply (worker, &reply, NULL) ||
+	    reply.status != EV_RENDER_WORKER_STATUS_OK) {
+		*load_failed = TRUE;
+		ev_render_worker_free (worker);
+
+		return NULL;
+	}
+	g_socket_set_timeout (worker->socket, RENDER_TIMEOUT);
+
+	ev_debug_message (DEBUG_JOBS, "Spawned render worker for %s", pool->uri);
+
+	return worker;
+}
+
+static EvRenderWorker *
+ev_render_worker_pool_acquire (EvRenderWorkerPool *pool,
+			       GCancellable       *cancellable)
+{
+	EvRenderWorker *worker = NULL;
+	gboolean        load_failed;
+
+	g_mutex_lock (&pool->mutex);
+
+	while (!pool->disabled && !g_cancellable_is_cancelled (cancellable)) {
+		if (pool->idle_workers->len > 0) {
+			worker = g_ptr_array_remove_index_fast (pool->idle_workers,
+								pool->idle_workers->len - 1);
+			break;
+		}
+
+		if (pool->n_workers < ev_render_worker_get_n_workers ()) {
+			pool->n_workers++;
+			g_mutex_unlock (&pool->mutex);
+
+			worker = ev_render_worker_spawn (pool, &load_failed);
+
+			g_mutex_lock (&pool->mutex);
+			if (!worker) {
+				pool->n_workers--;
+				/* Documents that workers can't load are
+				 * always rendered by the viewer.
+				 */
+				if (load_failed)
+					pool->disabled = TRUE;
+				g_cond_broadcast (&pool->cond);
+			}
+			break;
+		}
+
+		g_cond_wait (&pool->cond, &pool->mutex);
+	}
+
+	g_mutex_unlock (&pool->mutex);
+
+	return worker;
+}
+
+static void
+ev_render_worker_pool_release (EvRenderWorkerPool *pool,
+			       EvRenderWorker     *worker,
+			       gboolean            reusable)
+{
+	g_mutex_lock (&pool->mutex);
+	if (reusable) {
+		g_ptr_array_add (pool->idle_workers, worker);
+	} else {
+		pool->n_workers--;
+		ev_render_worker_free (worker);
+	}
+	g_cond_signal (&pool->cond);
+	g_mutex_unlock (&pool->mutex);
+}
+
+static void
+mapping_free (Mapping *mapping)
+{
+	munmap (mapping->data, mapping->size);
+	g_free (mapping);
+}
+
+static cairo_surface_t *
+surface_new_for_fd (const EvRenderWorkerReply *reply,
+		    gint                       fd)
+{
+	cairo_surface_t *surface;
+	Mapping         *mapping;
+	struct stat      st;
+	gsize            size;
+	gpointer         data;
+
+	if (reply->width <= 0 || reply->height <= 0 ||
+	    reply->stride != cairo_format_stride_for_width ((cairo_format_t) reply->format, reply->width))
+		return NULL;
+
+	/* Mapping past the end of the file would crash with SIGBUS
+	 * when the surface is used.
+	 */
+	size = (gsize) reply->stride * reply->height;
+	if (fstat (fd, &st) < 0 || st.st_size < 0 || (gsize) st.st_size < size)
+		return NULL;
+
+	data = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	surface = cairo_image_surface_create_for_data (data, (cairo_format_t) reply->format,
+						       reply->width, reply->height,
+						       reply->stride);
+	mapping = g_new (Mapping, 1);
+	mapping->data = data;
+	mapping->size = size;
+	cairo_surface_set_user_data (surface, &mapping_key, mapping,
+				     (cairo_destroy_func_t) mapping_free);
+#ifdef HAVE_HIDPI_SUPPORT
+	cairo_surface_set_device_scale (surface, reply->x_scale, reply->y_scale);
+#endif
+
+	return surface;
+}
+
+/**
+ * ev_render_worker_document_loaded:
+ * @document: an #EvDocument
+ *
+ * Records the modification time and size of the file @document was
+ * just loaded from. Workers refuse to load the file once it doesn't
+ * match anymore, and @document is then rendered by the viewer.
+ */
+void
+ev_render_worker_document_loaded (EvDocument *document)
+{
+	if (ev_render_worker_get_n_workers () == 0)
+		return;
+
+	g_mutex_lock (&pools_mutex);
+	if (!g_object_get_data (G_OBJECT (document), POOL_DATA_KEY))
+		ev_render_worker_pool_new (document, TRUE);
+	g_mutex_unlock (&pools_mutex);
+}
+
+/**
+ * ev_render_worker_can_render:
+ * @document: an #EvDocument
+ *
+ * Checks whether pages of @document can be rendered by workers, which
+ * isn't the case once it has changes that the file doesn't have. This
+ * must be called with the document lock held.
+ *
+ * Returns: whether ev_render_worker_render() can be used for @document
+ */
+gboolean
+ev_render_worker_can_render (EvDocument *document)
+{
+	EvRenderWorkerPool *pool;
+	gboolean            disabled;
+
+	if (ev_render_worker_get_n_workers () == 0)
+		return FALSE;
+
+	/* Workers have their own copy of the document, which doesn't
+	 * have the changes made in the viewer.
+	 */
+	if (ev_document_has_unsaved_changes (document))
+		return FALSE;
+
+	pool = ev_render_worker_pool_get (document);
+	g_mutex_lock (&pool->mutex);
+	disabled = pool->disabled;
+	g_mutex_unlock (&pool->mutex);
+
+	return !disabled;
+}
+
+/**
+ * ev_render_worker_render:
+ * @document: an #EvDocument
+ * @rc: an #EvRenderContext
+ * @cancellable: a #GCancellable
+ * @surface: (out): return location for the rendered surface
+ *
+ * Renders the page of @rc in a worker process. @document is only used
+ * to find its workers, so this doesn't need the document lock, and it
+ * is meant to be called from threads other than the one using the
+ * document, after ev_render_worker_can_render() returned %TRUE.
+ *
+ * If the job is cancelled while the worker is busy, the reply is still
+ * read so that the worker can be reused, and the page is discarded.
+ * Workers taking longer than RENDER_TIMEOUT to render a page are killed,
+ * so that a page hanging the backend doesn't keep the worker, and the
+ * jobs waiting for it, blocked forever.
+ *
+ * Returns: %FALSE if @document can't be rendered by workers, in which
+ *   case it must be rendered by the caller, or %TRUE otherwise. @surface
+ *   is set to %NULL when the worker failed to render the page.
+ */
+gboolean
+ev_render_worker_render (EvDocument       *document,
+			 EvRenderContext  *rc,
+			 GCancellable     *cancellable,
+			 cairo_surface_t **surface)
+{
+	EvRenderWorkerPool   *pool;
+	EvRenderWorker       *worker;
+	EvRenderWorkerRequest request = { 0 };
+	EvRenderWorkerReply   reply;
+	gint                  fd;
+	gboolean              reusable;
+
+	*surface = NULL;
+
+	if (ev_render_worker_get_n_workers () == 0)
+		return FALSE;
+
+	pool = ev_render_worker_pool_get (document);
+	worker = ev_render_worker_pool_acquire (pool, cancellable);
+	if (!worker) {
+		gboolean disabled;
+
+		g_mutex_lock (&pool->mutex);
+		disabled = pool->disabled;
+		g_mutex_unlock (&pool->mutex);
+
+		return !disabled;
+	}
+
+	request.page = rc->page->index;
+	request.rotation = rc->rotation;
+	request.scale = rc->scale;
+	request.target_width = rc->target_width;
+	request.target_height = rc->target_height;
+	request.has_region = rc->has_region;
+	request.region_x = rc->region.x;
+	request.region_y = rc->region.y;
+	request.region_width = rc->region.width;
+	request.region_height = rc->region.height;
+
+	if (g_socket_send (worker->socket, (const gchar *) &request, sizeof (request),
+			   NULL, NULL) != sizeof (request)) {
+		g_warning ("Render worker for %s exited unexpectedly", pool->uri);
+		ev_render_worker_pool_release (pool, worker, FALSE);
+
+		return TRUE;
+	}
+
+	reusable = ev_render_worker_receive_reply (worker, &reply, &fd);
+	if (!reusable) {
+		g_warning ("Render worker for %s crashed or timed out rendering page %d",
+			   pool->uri, request.page);
+	} else if (reply.status == EV_RENDER_WORKER_STATUS_OK && fd != -1 &&
+		   !g_cancellable_is_cancelled (cancellable)) {
+		*surface = surface_new_for_fd (&reply, fd);
+	}
+
+	if (fd != -1)
+		close (fd);
+
+	ev_render_worker_pool_release (pool, worker, reusable);
+
+	return TRUE;
+}
+
+#else /* !G_OS_UNIX */
+
+void
+ev_render_worker_document_loaded (EvDocument *document)
+{
+}
+
+gboolean
+ev_render_worker_can_render (EvDocument *document)
+{
+	return FALSE;
+}
+
+gboolean
+ev_render_worker_render (EvDocument       *document,
+			 EvRenderContext  *rc,
+			 GCancellable     *cancellable,
+			 cairo_surface_t **surface)
+{
+	*surface = NULL;
+
+	return FALSE;
+}
+
+#endif /* G_OS_UNIX */
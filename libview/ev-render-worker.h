@@ -0,0 +1,87 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Render workers are helper processes loading their own copy of a
+ * document and rendering its pages on behalf of the viewer, so that
+ * pages are rendered in parallel even with backends that are not
+ * thread safe, and a backend crashing or hanging on a page doesn't
+ * take the viewer down with it. They are disabled unless the
+ * EV_RENDER_WORKERS environment variable is set to the number of
+ * workers to use per document.
+ *
+ * Workers are given the URI of the document, and the modification time
+ * and size of the file the viewer loaded, so that they don't render a
+ * different version of the file. They talk to the viewer through a
+ * unix socket passed as file descriptor 3. Once the document is loaded
+ * the worker sends a first reply with the load status, then it sends a
+ * reply for every request, with the rendered page attached as a shared
+ * memory file descriptor.
+ */
+
+#pragma once
+
+#if !defined (EVINCE_COMPILATION)
+#error "This is a private header."
+#endif
+
+#include <cairo.h>
+
+#include <evince-document.h>
+
+G_BEGIN_DECLS
+
+#define EV_RENDER_WORKER_SOCKET_FD 3
+
+typedef struct {
+	gint32  page;
+	gint32  rotation;
+	gdouble scale;
+	gint32  target_width;
+	gint32  target_height;
+	gint32  has_region;
+	gint32  region_x;
+	gint32  region_y;
+	gint32  region_width;
+	gint32  region_height;
+} EvRenderWorkerRequest;
+
+typedef enum {
+	EV_RENDER_WORKER_STATUS_OK,
+	EV_RENDER_WORKER_STATUS_LOAD_FAILED,
+	EV_RENDER_WORKER_STATUS_RENDER_FAILED,
+	EV_RENDER_WORKER_STATUS_FILE_CHANGED
+} EvRenderWorkerStatus;
+
+typedef struct {
+	gint32  status;
+	gint32  format;
+	gint32  width;
+	gint32  height;
+	gint32  stride;
+	gdouble x_scale;
+	gdouble y_scale;
+} EvRenderWorkerReply;
+
+guint    ev_render_worker_get_n_workers   (void);
+void     ev_render_worker_document_loaded (EvDocument       *document);
+gboolean ev_render_worker_can_render      (EvDocument       *document);
+gboolean ev_render_worker_render          (EvDocument       *document,
+					   EvRenderContext  *rc,
+					   GCancellable     *cancellable,
+					   cairo_surface_t **surface);
+
+G_END_DECLS
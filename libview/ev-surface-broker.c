@@ -0,0 +1,303 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include "ev-surface-broker.h"
+
+#define BROKER_DATA_KEY "ev-surface-broker"
+
+typedef struct {
+	cairo_surface_t *surface;
+	gint             rotation;
+	gboolean         inverted_colors;
+} BrokerSurface;
+
+/* Surfaces are added and removed from the main thread, but they are
+ * read by thumbnail jobs from the job threads, so both the tables and
+ * the pixel data are only accessed with this lock held. Owners of a
+ * registered surface must remove it before modifying it in place.
+ */
+static GMutex broker_mutex;
+
+static void
+broker_surface_free (BrokerSurface *broker_surface)
+{
+	cairo_surface_destroy (broker_surface->surface);
+	g_slice_free (BrokerSurface, broker_surface);
+}
+
+static GHashTable *
+ev_surface_broker_get_table (EvDocument *document,
+			     gboolean    create)
+{
+	GHashTable *table;
+
+	table = g_object_get_data (G_OBJECT (document), BROKER_DATA_KEY);
+	if (table || !create)
+		return table;
+
+	table = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+				       NULL,
+				       (GDestroyNotify) broker_surface_free);
+	g_object_set_data_full (G_OBJECT (document), BROKER_DATA_KEY,
+				table,
+				(GDestroyNotify) g_hash_table_destroy);
+
+	return table;
+}
+
+/**
+ * ev_surface_broker_add_surface:
+ * @document: the #EvDocument @surface was rendered from
+ * @page: the page index
+ * @rotation: the rotation @surface was rendered with
+ * @inverted_colors: whether the colors of @surface are inverted
+ * @surface: an image surface containing the whole page
+ *
+ * Makes @surface available to other consumers of @page. The broker
+ * keeps a reference to @surface until it is removed with
+ * ev_surface_broker_remove_surface() or replaced by another surface
+ * for the same page.
+ */
+void
+ev_surface_broker_add_surface (EvDocument      *document,
+			       gint             page,
+			       gint             rotation,
+			       gboolean         inverted_colors,
+			       cairo_surface_t *surface)
+{
+	BrokerSurface *broker_surface;
+
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	if (!surface || cairo_surface_get_type (surface) != CAIRO_SURFACE_TYPE_IMAGE)
+		return;
+
+	broker_surface = g_slice_new (BrokerSurface);
+	broker_surface->surface = cairo_surface_reference (surface);
+	broker_surface->rotation = rotation;
+	broker_surface->inverted_colors = inverted_colors;
+
+	g_mutex_lock (&broker_mutex);
+	g_hash_table_insert (ev_surface_broker_get_table (document, TRUE),
+			     GINT_TO_POINTER (page),
+			     broker_surface);
+	g_mutex_unlock (&broker_mutex);
+}
+
+static gboolean
+broker_surface_matches (gpointer key,
+			gpointer value,
+			gpointer user_data)
+{
+	BrokerSurface *broker_surface = value;
+
+	return broker_surface->surface == user_data;
+}
+
+/**
+ * ev_surface_broker_remove_surface:
+ * @document: the #EvDocument @surface was added for
+ * @surface: a surface previously added with ev_surface_broker_add_surface()
+ *
+ * Stops sharing @surface. Once this returns no job thread is reading
+ * from @surface anymore, so it can be safely modified or destroyed.
+ */
+void
+ev_surface_broker_remove_surface (EvDocument      *document,
+				  cairo_surface_t *surface)
+{
+	GHashTable *table;
+
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	if (!surface)
+		return;
+
+	g_mutex_lock (&broker_mutex);
+	table = ev_surface_broker_get_table (document, FALSE);
+	if (table)
+		g_hash_table_foreach_remove (table, broker_surface_matches, surface);
+	g_mutex_unlock (&broker_mutex);
+}
+
+/**
+ * ev_surface_broker_invert_surface:
+ * @document: the #EvDocument @surface was added for
+ * @surface: an image surface
+ *
+ * Inverts the colors of @surface in place, keeping the shared state of
+ * @surface up to date if it was added to the broker.
+ */
+void
+ev_surface_broker_invert_surface (EvDocument      *document,
+				  cairo_surface_t *surface)
+{
+	GHashTable    *table;
+	BrokerSurface *broker_surface;
+
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	g_mutex_lock (&broker_mutex);
+	ev_document_misc_invert_surface (surface);
+	table = ev_surface_broker_get_table (document, FALSE);
+	if (table) {
+		broker_surface = g_hash_table_find (table, broker_surface_matches, surface);
+		if (broker_surface)
+			broker_surface->inverted_colors = !broker_surface->inverted_colors;
+	}
+	g_mutex_unlock (&broker_mutex);
+}
+
+/* Must be called with broker_mutex held */
+static cairo_surface_t *
+broker_surface_scale (BrokerSurface *broker_surface,
+		      gint           width,
+		      gint           height)
+{
+	cairo_surface_t *surface;
+	cairo_t         *cr;
+	gint             source_width, source_height;
+	gdouble          x_scale, y_scale;
+
+	source_width = cairo_image_surface_get_width (broker_surface->surface);
+	source_height = cairo_image_surface_get_height (broker_surface->surface);
+	cairo_surface_get_device_scale (broker_surface->surface, &x_scale, &y_scale);
+
+	surface = cairo_image_surface_create (cairo_image_surface_get_format (broker_surface->surface),
+					      width, height);
+	cr = cairo_create (surface);
+	cairo_scale (cr,
+		     (gdouble) width * x_scale / source_width,
+		     (gdouble) height * y_scale / source_height);
+	cairo_set_source_surface (cr, broker_surface->surface, 0, 0);
+	cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_GOOD);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+
+	if (broker_surface->inverted_colors)
+		ev_document_misc_invert_surface (surface);
+
+	return surface;
+}
+
+/* Must be called with broker_mutex held */
+static BrokerSurface *
+ev_surface_broker_lookup (EvDocument *document,
+			  gint        page,
+			  gint        rotation)
+{
+	GHashTable    *table;
+	BrokerSurface *broker_surface = NULL;
+
+	table = ev_surface_broker_get_table (document, FALSE);
+	if (table)
+		broker_surface = g_hash_table_lookup (table, GINT_TO_POINTER (page));
+	if (!broker_surface || broker_surface->rotation != rotation)
+		return NULL;
+
+	return broker_surface;
+}
+
+/**
+ * ev_surface_broker_scale_surface:
+ * @document: an #EvDocument
+ * @page: the page index
+ * @rotation: the rotation the result should have
+ * @width: the width of the result in pixels
+ * @height: the height of the result in pixels
+ *
+ * Downscales the surface shared for @page to @width x @height pixels.
+ * The result never has inverted colors, whatever the state of the
+ * shared surface is.
+ *
+ * Returns: (transfer full) (nullable): a new image surface, or %NULL
+ *   when there isn't a shared surface for @page rendered with @rotation
+ *   and at least as large as the requested size.
+ */
+cairo_surface_t *
+ev_surface_broker_scale_surface (EvDocument *document,
+				 gint        page,
+				 gint        rotation,
+				 gint        width,
+				 gint        height)
+{
+	BrokerSurface   *broker_surface;
+	cairo_surface_t *surface = NULL;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
+
+	if (width <= 0 || height <= 0)
+		return NULL;
+
+	g_mutex_lock (&broker_mutex);
+
+	broker_surface = ev_surface_broker_lookup (document, page, rotation);
+
+	/* Upscaling would give a worse result than rendering */
+	if (broker_surface &&
+	    cairo_image_surface_get_width (broker_surface->surface) >= width &&
+	    cairo_image_surface_get_height (broker_surface->surface) >= height)
+		surface = broker_surface_scale (broker_surface, width, height);
+
+	g_mutex_unlock (&broker_mutex);
+
+	return surface;
+}
+
+/**
+ * ev_surface_broker_copy_surface:
+ * @document: an #EvDocument
+ * @page: the page index
+ * @rotation: the rotation the result should have
+ * @width: the width of the result in pixels
+ * @height: the height of the result in pixels
+ *
+ * Copies the surface shared for @page when it was rendered at exactly
+ * @width x @height pixels, so that another view of @document showing
+ * @page at the same size doesn't need to render it again. Like with
+ * ev_surface_broker_scale_surface(), the result never has inverted
+ * colors.
+ *
+ * Returns: (transfer full) (nullable): a new image surface, or %NULL
+ *   when there isn't a shared surface for @page with that size
+ */
+cairo_surface_t *
+ev_surface_broker_copy_surface (EvDocument *document,
+				gint        page,
+				gint        rotation,
+				gint        width,
+				gint        height)
+{
+	BrokerSurface   *broker_surface;
+	cairo_surface_t *surface = NULL;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
+
+	g_mutex_lock (&broker_mutex);
+
+	broker_surface = ev_surface_broker_lookup (document, page, rotation);
+	if (broker_surface &&
+	    cairo_image_surface_get_width (broker_surface->surface) == width &&
+	    cairo_image_surface_get_height (broker_surface->surface) == height)
+		surface = broker_surface_scale (broker_surface, width, height);
+
+	g_mutex_unlock (&broker_mutex);
+
+	return surface;
+}
@@ -0,0 +1,57 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* The surface broker keeps track of the page surfaces already rendered
+ * for a document, so that jobs needing a smaller version of a page
+ * (thumbnails, link previews) can downscale them, and other views of the
+ * document can copy them, instead of asking the backend to render the
+ * page again.
+ */
+
+#pragma once
+
+#if !defined (EVINCE_COMPILATION)
+#error "This is a private header."
+#endif
+
+#include <cairo.h>
+
+#include <evince-document.h>
+
+G_BEGIN_DECLS
+
+void             ev_surface_broker_add_surface    (EvDocument      *document,
+						   gint             page,
+						   gint             rotation,
+						   gboolean         inverted_colors,
+						   cairo_surface_t *surface);
+void             ev_surface_broker_remove_surface (EvDocument      *document,
+						   cairo_surface_t *surface);
+void             ev_surface_broker_invert_surface (EvDocument      *document,
+						   cairo_surface_t *surface);
+cairo_surface_t *ev_surface_broker_scale_surface  (EvDocument      *document,
+						   gint             page,
+						   gint             rotation,
+						   gint             width,
+						   gint             height);
+cairo_surface_t *ev_surface_broker_copy_surface   (EvDocument      *document,
+						   gint             page,
+						   gint             rotation,
+						   gint             width,
+						   gint             height);
+
+G_END_DECLS
@@ -21,7 +21,7 @@
 
 #include <glib.h>
 #include <math.h>
-#include <gdk/gdk.h>
+#include <gtk/gtk.h>
 #include "ev-timeline.h"
 
 #define MSECS_PER_SEC 1000
@@ -34,8 +34,11 @@ struct EvTimelinePrivate {
 	guint duration;
 	guint fps;
 	guint source_id;
+	guint tick_id;
 
+	GtkWidget *widget;
 	GTimer *timer;
+	gdouble progress;
 
 	guint loop : 1;
 };
@@ -57,6 +60,8 @@ enum {
 
 static guint signals [LAST_SIGNAL] = { 0, };
 
+static gboolean ev_timeline_run_frame (EvTimeline *timeline);
+
 
 G_DEFINE_TYPE_WITH_PRIVATE (EvTimeline, ev_timeline, G_TYPE_OBJECT)
 
@@ -124,18 +129,89 @@ ev_timeline_get_property (GObject    *object,
 	}
 }
 
+static gboolean
+ev_timeline_tick_cb (GtkWidget     *widget,
+		     GdkFrameClock *frame_clock,
+		     EvTimeline    *timeline)
+{
+	return ev_timeline_run_frame (timeline) ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
 static void
-ev_timeline_finalize (GObject *object)
+ev_timeline_add_source (EvTimeline *timeline)
 {
 	EvTimelinePrivate *priv;
 
-	priv = ev_timeline_get_instance_private (EV_TIMELINE (object));
+	priv = ev_timeline_get_instance_private (timeline);
+
+	/* Sync the frames to the display when we have a widget to
+	 * get the frame clock from, fall back to a timeout otherwise.
+	 */
+	if (priv->widget && gtk_widget_get_realized (priv->widget)) {
+		priv->tick_id = gtk_widget_add_tick_callback (priv->widget,
+							      (GtkTickCallback) ev_timeline_tick_cb,
+							      timeline, NULL);
+	} else {
+		priv->source_id = g_timeout_add (FRAME_INTERVAL (priv->fps),
+						 (GSourceFunc) ev_timeline_run_frame,
+						 timeline);
+	}
+}
+
+static void
+ev_timeline_remove_source (EvTimeline *timeline)
+{
+	EvTimelinePrivate *priv;
+
+	priv = ev_timeline_get_instance_private (timeline);
 
 	if (priv->source_id) {
 		g_source_remove (priv->source_id);
 		priv->source_id = 0;
 	}
 
+	if (priv->tick_id) {
+		if (priv->widget)
+			gtk_widget_remove_tick_callback (priv->widget, priv->tick_id);
+		priv->tick_id = 0;
+	}
+}
+
+/* Tick callbacks are dropped with the widget, which would leave the
+ * timeline running forever without frames.
+ */
+static void
+ev_timeline_widget_destroyed (GtkWidget  *widget,
+			      EvTimeline *timeline)
+{
+	EvTimelinePrivate *priv;
+
+	priv = ev_timeline_get_instance_private (timeline);
+
+	if (priv->tick_id) {
+		gtk_widget_remove_tick_callback (widget, priv->tick_id);
+		priv->tick_id = 0;
+	}
+}
+
+static void
+ev_timeline_finalize (GObject *object)
+{
+	EvTimelinePrivate *priv;
+
+	priv = ev_timeline_get_instance_private (EV_TIMELINE (object));
+
+	ev_timeline_remove_source (EV_TIMELINE (object));
+
+	if (priv->widget) {
+		g_signal_handlers_disconnect_by_func (priv->widget,
+						      ev_timeline_widget_destroyed,
+						      object);
+		g_object_remove_weak_pointer (G_OBJECT (priv->widget),
+					      (gpointer *) &priv->widget);
+		priv->widget = NULL;
+	}
+
 	if (priv->timer)
 		g_timer_destroy (priv->timer);
 
@@ -155,14 +231,16 @@ ev_timeline_run_frame (EvTimeline *timeline)
 	progress = (gdouble) elapsed_time / priv->duration;
 	progress = CLAMP (progress, 0., 1.);
 
+	/* Sample the progress once per frame, so that everything
+	 * painted for this frame uses the same value.
+	 */
+	priv->progress = progress;
+
 	g_signal_emit (timeline, signals [FRAME], 0, progress);
 
 	if (progress >= 1.0) {
 		if (!priv->loop) {
-			if (priv->source_id) {
-				g_source_remove (priv->source_id);
-				priv->source_id = 0;
-			}
+			ev_timeline_remove_source (timeline);
 
 			g_signal_emit (timeline, signals [FINISHED], 0);
 			return FALSE;
@@ -181,7 +259,7 @@ ev_timeline_real_start (EvTimeline *timeline)
 
 	priv = ev_timeline_get_instance_private (timeline);
 
-	if (!priv->source_id) {
+	if (!ev_timeline_is_running (timeline)) {
 		if (priv->timer)
 			g_timer_continue (priv->timer);
 		else
@@ -190,11 +268,11 @@ ev_timeline_real_start (EvTimeline *timeline)
 		/* sanity check */
 		g_assert (priv->fps > 0);
 
+		priv->progress = CLAMP (g_timer_elapsed (priv->timer, NULL) * 1000 / priv->duration, 0., 1.);
+
 		g_signal_emit (timeline, signals [STARTED], 0);
 
-		priv->source_id = g_timeout_add (FRAME_INTERVAL (priv->fps),
-						 (GSourceFunc) ev_timeline_run_frame,
-						 timeline);
+		ev_timeline_add_source (timeline);
 	}
 }
 
@@ -300,9 +378,8 @@ ev_timeline_pause (EvTimeline *timeline)
 
 	priv = ev_timeline_get_instance_private (timeline);
 
-	if (priv->source_id) {
-		g_source_remove (priv->source_id);
-		priv->source_id = 0;
+	if (ev_timeline_is_running (timeline)) {
+		ev_timeline_remove_source (timeline);
 		g_timer_stop (priv->timer);
 		g_signal_emit (timeline, signals [PAUSED], 0);
 	}
@@ -337,7 +414,7 @@ ev_timeline_is_running (EvTimeline *timeline)
 
 	priv = ev_timeline_get_instance_private (timeline);
 
-	return (priv->source_id != 0);
+	return (priv->source_id != 0 || priv->tick_id != 0);
 }
 
 guint
@@ -363,7 +440,7 @@ ev_timeline_set_fps (EvTimeline *timeline,
 
 	priv->fps = fps;
 
-	if (ev_timeline_is_running (timeline)) {
+	if (priv->source_id) {
 		g_source_remove (priv->source_id);
 		priv->source_id = g_timeout_add (FRAME_INTERVAL (priv->fps),
 						 (GSourceFunc) ev_timeline_run_frame,
@@ -439,8 +516,54 @@ ev_timeline_get_progress (EvTimeline *timeline)
 	if (!priv->timer)
 		return 0.;
 
+	if (ev_timeline_is_running (timeline))
+		return priv->progress;
+
 	elapsed_time = (guint) (g_timer_elapsed (priv->timer, NULL) * 1000);
 	progress = (gdouble) elapsed_time / priv->duration;
 
 	return CLAMP (progress, 0., 1.);
 }
+
+/* Makes the timeline run its frames from the frame clock of @widget
+ * instead of a timeout, so they are in sync with the display refresh.
+ * The fps property is ignored in that case.
+ */
+void
+ev_timeline_set_widget (EvTimeline *timeline,
+			GtkWidget  *widget)
+{
+	EvTimelinePrivate *priv;
+	gboolean           running;
+
+	g_return_if_fail (EV_IS_TIMELINE (timeline));
+	g_return_if_fail (widget == NULL || GTK_IS_WIDGET (widget));
+
+	priv = ev_timeline_get_instance_private (timeline);
+
+	if (priv->widget == widget)
+		return;
+
+	running = ev_timeline_is_running (timeline);
+	if (running)
+		ev_timeline_remove_source (timeline);
+
+	if (priv->widget) {
+		g_signal_handlers_disconnect_by_func (priv->widget,
+						      ev_timeline_widget_destroyed,
+						      timeline);
+		g_object_remove_weak_pointer (G_OBJECT (priv->widget),
+					      (gpointer *) &priv->widget);
+	}
+	priv->widget = widget;
+	if (priv->widget) {
+		g_object_add_weak_pointer (G_OBJECT (priv->widget),
+					   (gpointer *) &priv->widget);
+		g_signal_connect (priv->widget, "destroy",
+				  G_CALLBACK (ev_timeline_widget_destroyed),
+				  timeline);
+	}
+
+	if (running)
+		ev_timeline_add_source (timeline);
+}
@@ -25,7 +25,7 @@
 #error "This is a private header."
 #endif
 
-#include <glib-object.h>
+#include <gtk/gtk.h>
 
 G_BEGIN_DECLS
 
@@ -83,5 +83,8 @@ void                  ev_timeline_set_duration       (EvTimeline             *ti
 
 gdouble               ev_timeline_get_progress       (EvTimeline             *timeline);
 
+void                  ev_timeline_set_widget         (EvTimeline             *timeline,
+						      GtkWidget              *widget);
+
 
 G_END_DECLS
@@ -19,6 +19,7 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <math.h>
 #include <cairo.h>
 #include <gdk/gdk.h>
 #include "ev-transition-animation.h"
@@ -32,6 +33,9 @@ struct EvTransitionAnimationPrivate {
 	EvTransitionEffect *effect;
 	cairo_surface_t *origin_surface;
 	cairo_surface_t *dest_surface;
+
+	/* Progress of the last frame painted with both surfaces */
+	gdouble painted_progress;
 };
 
 enum {
@@ -48,6 +52,10 @@ G_DEFINE_TYPE_WITH_PRIVATE (EvTransitionAnimation, ev_transition_animation, EV_T
 static void
 ev_transition_animation_init (EvTransitionAnimation *animation)
 {
+	EvTransitionAnimationPrivate *priv;
+
+	priv = ev_transition_animation_get_instance_private (animation);
+	priv->painted_progress = -1.;
 }
 
 static void
@@ -552,6 +560,7 @@ ev_transition_animation_paint (EvTransitionAnimation *animation,
 
 	g_object_get (priv->effect, "type", &type, NULL);
 	progress = ev_timeline_get_progress (EV_TIMELINE (animation));
+	priv->painted_progress = progress;
 
 	switch (type) {
 	case EV_TRANSITION_EFFECT_REPLACE:
@@ -602,6 +611,121 @@ ev_transition_animation_paint (EvTransitionAnimation *animation,
 	}
 }
 
+static void
+damage_rectangle (GdkRectangle *area,
+		  gdouble       x,
+		  gdouble       y,
+		  gdouble       width,
+		  gdouble       height)
+{
+	/* Round outwards and leave room for antialiased edges */
+	area->x = (gint) floor (x) - 1;
+	area->y = (gint) floor (y) - 1;
+	area->width = (gint) ceil (x + width) + 1 - area->x;
+	area->height = (gint) ceil (y + height) + 1 - area->y;
+}
+
+/**
+ * ev_transition_animation_get_damage_area:
+ * @animation: a #EvTransitionAnimation
+ * @page_area: the area where the animation is painted
+ * @area: (out): return location for the area to redraw
+ *
+ * Gets the part of @page_area that changes between the last painted
+ * frame and the current one. For effects that only reveal part of the
+ * slide on every frame (wipe, box, split) this is much smaller than the
+ * whole page, everything else needs the whole page to be redrawn.
+ */
+void
+ev_transition_animation_get_damage_area (EvTransitionAnimation *animation,
+					 GdkRectangle           page_area,
+					 GdkRectangle          *area)
+{
+	EvTransitionAnimationPrivate *priv;
+	EvTransitionEffectType        type;
+	EvTransitionEffectAlignment   alignment;
+	EvTransitionEffectDirection   direction;
+	gint                          angle;
+	gdouble                       from, to, p;
+	gdouble                       width, height;
+
+	g_return_if_fail (EV_IS_TRANSITION_ANIMATION (animation));
+	g_return_if_fail (area != NULL);
+
+	priv = ev_transition_animation_get_instance_private (animation);
+
+	*area = page_area;
+	if (!priv->dest_surface || priv->painted_progress < 0.)
+		return;
+
+	from = priv->painted_progress;
+	to = ev_timeline_get_progress (EV_TIMELINE (animation));
+	if (to < from) {
+		/* looping */
+		return;
+	}
+
+	width = page_area.width;
+	height = page_area.height;
+
+	g_object_get (priv->effect,
+		      "type", &type,
+		      "alignment", &alignment,
+		      "direction", &direction,
+		      "angle", &angle,
+		      NULL);
+
+	switch (type) {
+	case EV_TRANSITION_EFFECT_WIPE:
+		if (angle == 0)
+			damage_rectangle (area, width * from, 0, width * (to - from), height);
+		else if (angle <= 90)
+			damage_rectangle (area, 0, height * (1 - to), width, height * (to - from));
+		else if (angle <= 180)
+			damage_rectangle (area, width * (1 - to), 0, width * (to - from), height);
+		else if (angle <= 270)
+			damage_rectangle (area, 0, height * from, width, height * (to - from));
+		else
+			return;
+		break;
+	case EV_TRANSITION_EFFECT_BOX:
+		/* The changed pixels are inside the larger of both boxes */
+		if (direction == EV_TRANSITION_DIRECTION_INWARD) {
+			p = from;
+			damage_rectangle (area,
+					  width * p / 2, height * p / 2,
+					  width * (1 - p), height * (1 - p));
+		} else {
+			p = to;
+			damage_rectangle (area,
+					  (width / 2) - (width * p / 2),
+					  (height / 2) - (height * p / 2),
+					  width * p, height * p);
+		}
+		break;
+	case EV_TRANSITION_EFFECT_SPLIT:
+		p = direction == EV_TRANSITION_DIRECTION_INWARD ? from : to;
+		if (alignment == EV_TRANSITION_ALIGNMENT_HORIZONTAL) {
+			if (direction == EV_TRANSITION_DIRECTION_INWARD)
+				damage_rectangle (area, 0, height * p / 2, width, height * (1 - p));
+			else
+				damage_rectangle (area, 0, (height / 2) - (height * p / 2), width, height * p);
+		} else {
+			if (direction == EV_TRANSITION_DIRECTION_INWARD)
+				damage_rectangle (area, width * p / 2, 0, width * (1 - p), height);
+			else
+				damage_rectangle (area, (width / 2) - (width * p / 2), 0, width * p, height);
+		}
+		break;
+	default:
+		return;
+	}
+
+	area->x += page_area.x;
+	area->y += page_area.y;
+	gdk_rectangle_intersect (area, &page_area, area);
+}
+
 EvTransitionAnimation *
 ev_transition_animation_new (EvTransitionEffect *effect)
 {
@@ -658,6 +782,7 @@ ev_transition_animation_set_dest_surface (EvTransitionAnimation *animation,
 		cairo_surface_destroy (priv->dest_surface);
 
 	priv->dest_surface = surface;
+	priv->painted_progress = -1.;
 	g_object_notify (G_OBJECT (animation), "dest-surface");
 
 	if (priv->origin_surface && priv->dest_surface)
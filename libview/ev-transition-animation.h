@@ -65,5 +65,8 @@ void                    ev_transition_animation_paint              (EvTransition
 								    cairo_t               *cr,
 								    GdkRectangle           page_area);
 gboolean                ev_transition_animation_ready              (EvTransitionAnimation *animation);
+void                    ev_transition_animation_get_damage_area    (EvTransitionAnimation *animation,
+								    GdkRectangle           page_area,
+								    GdkRectangle          *area);
 
 G_END_DECLS
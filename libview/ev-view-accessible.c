@@ -52,6 +52,11 @@ static const gchar *const ev_view_accessible_action_descriptions[] =
 	NULL
 };
 
+/* Number of pages around the visible range whose accessibles are kept
+ * alive even if no assistive technology holds a reference to them.
+ */
+#define KEEP_PAGES_AROUND 10
+
 struct _EvViewAccessiblePrivate {
 	EvDocumentModel *model;
 
@@ -64,6 +69,7 @@ struct _EvViewAccessiblePrivate {
 	gint start_page;
 	gint end_page;
 	AtkObject *focused_element;
+	gint focused_page;
 
 	GPtrArray *children;
 };
@@ -80,6 +86,79 @@ get_relevant_page (EvView *view)
 	return ev_view_is_caret_navigation_enabled (view) ? view->cursor_page : view->current_page;
 }
 
+/* Page accessibles are created on demand, so most of the slots of the
+ * children array are usually empty.
+ */
+static EvPageAccessible *
+peek_page_accessible (EvViewAccessible *self,
+		      gint              page)
+{
+	if (self->priv->children == NULL || page < 0 || page >= self->priv->children->len)
+		return NULL;
+
+	return g_ptr_array_index (self->priv->children, page);
+}
+
+static EvPageAccessible *
+get_page_accessible (EvViewAccessible *self,
+		     gint              page)
+{
+	EvPageAccessible *child;
+
+	if (self->priv->children == NULL || page < 0 || page >= self->priv->children->len)
+		return NULL;
+
+	child = g_ptr_array_index (self->priv->children, page);
+	if (child == NULL) {
+		child = ev_page_accessible_new (self, page);
+		g_ptr_array_index (self->priv->children, page) = child;
+	}
+
+	return child;
+}
+
+static void
+page_accessible_free (EvPageAccessible *child)
+{
+	if (child)
+		g_object_unref (child);
+}
+
+/* Drop the page accessibles that moved far from the visible range, when
+ * nobody else is using them or their children, they will be created
+ * again if they are requested. Only the pages that were kept for the
+ * previous range are checked.
+ */
+static void
+release_unused_children (EvViewAccessible *self,
+			 gint              previous_start,
+			 gint              previous_end)
+{
+	EvViewAccessiblePrivate *priv = self->priv;
+	EvPageAccessible *child;
+	gint i;
+
+	for (i = MAX (previous_start - KEEP_PAGES_AROUND, 0);
+	     i <= previous_end + KEEP_PAGES_AROUND && i < priv->children->len;
+	     i++) {
+		if (i >= priv->start_page - KEEP_PAGES_AROUND &&
+		    i <= priv->end_page + KEEP_PAGES_AROUND)
+			continue;
+
+		if (i == priv->previous_cursor_page ||
+		    (priv->focused_element && i == priv->focused_page))
+			continue;
+
+		child = g_ptr_array_index (priv->children, i);
+		if (child == NULL || G_OBJECT (child)->ref_count > 1 ||
+		    ev_page_accessible_has_children_in_use (child))
+			continue;
+
+		g_ptr_array_index (priv->children, i) = NULL;
+		g_object_unref (child);
+	}
+}
+
 static void
 clear_children (EvViewAccessible *self)
 {
@@ -91,9 +170,12 @@ clear_children (EvViewAccessible *self)
 
 	for (i = 0; i < self->priv->children->len; i++) {
 		child = g_ptr_array_index (self->priv->children, i);
-		atk_object_notify_state_change (child, ATK_STATE_DEFUNCT, TRUE);
+		if (child)
+			atk_object_notify_state_change (child, ATK_STATE_DEFUNCT, TRUE);
 	}
 
+	self->priv->focused_element = NULL;
+
 	g_clear_pointer (&self->priv->children, g_ptr_array_unref);
 }
 
@@ -136,6 +218,7 @@ ev_view_accessible_initialize (AtkObject *obj,
 	priv->previous_cursor_page = -1;
 	priv->start_page = 0;
 	priv->end_page = -1;
+	priv->focused_page = -1;
 }
 
 gint
@@ -153,18 +236,21 @@ ev_view_accessible_ref_child (AtkObject *obj,
 
 	g_return_val_if_fail (EV_IS_VIEW_ACCESSIBLE (obj), NULL);
 	self = EV_VIEW_ACCESSIBLE (obj);
-	g_return_val_if_fail (i >= 0 || i < ev_view_accessible_get_n_pages (self), NULL);
+	g_return_val_if_fail (i >= 0 && i < ev_view_accessible_get_n_pages (self), NULL);
 
 	view = EV_VIEW (gtk_accessible_get_widget (GTK_ACCESSIBLE (obj)));
 	if (view == NULL)
 		return NULL;
 
 	/* If a given page is requested, we assume that the text would
-	 * be requested soon, so we need to be sure that is cached.*/
+	 * be requested soon, so we schedule it to be cached. The page
+	 * data is loaded by a job, and the page accessible builds its
+	 * children once the page cache notifies that the page is ready.
+	 */
 	if (view->page_cache)
 		ev_page_cache_ensure_page (view->page_cache, i);
 
-	return g_object_ref (g_ptr_array_index (self->priv->children, i));
+	return g_object_ref (get_page_accessible (self, i));
 }
 
 static gint
@@ -337,13 +423,16 @@ ev_view_accessible_cursor_moved (EvView *view,
 
 		if (priv->previous_cursor_page >= 0) {
 			AtkObject *previous_page = NULL;
-			previous_page = g_ptr_array_index (priv->children,
-							   priv->previous_cursor_page);
-			atk_object_notify_state_change (previous_page, ATK_STATE_FOCUSED, FALSE);
+			previous_page = ATK_OBJECT (peek_page_accessible (accessible,
+									  priv->previous_cursor_page));
+			if (previous_page)
+				atk_object_notify_state_change (previous_page, ATK_STATE_FOCUSED, FALSE);
 		}
 
 		priv->previous_cursor_page = page;
-		current_page = g_ptr_array_index (priv->children, page);
+		current_page = ATK_OBJECT (get_page_accessible (accessible, page));
+		if (current_page == NULL)
+			return;
 		atk_object_notify_state_change (current_page, ATK_STATE_FOCUSED, TRUE);
 
 #if ATK_CHECK_VERSION (2, 11, 2)
@@ -352,7 +441,7 @@ ev_view_accessible_cursor_moved (EvView *view,
 #endif
 	}
 
-	page_accessible = g_ptr_array_index (priv->children, page);
+	page_accessible = get_page_accessible (accessible, page);
 	g_signal_emit_by_name (page_accessible, "text-caret-moved", offset);
 }
 
@@ -362,9 +451,10 @@ ev_view_accessible_selection_changed (EvView *view,
 {
 	AtkObject *page_accessible;
 
-	page_accessible = g_ptr_array_index (view_accessible->priv->children,
-					     get_relevant_page (view));
-	g_signal_emit_by_name (page_accessible, "text-selection-changed");
+	page_accessible = ATK_OBJECT (get_page_accessible (view_accessible,
+							   get_relevant_page (view)));
+	if (page_accessible)
+		g_signal_emit_by_name (page_accessible, "text-selection-changed");
 }
 
 static void
@@ -385,19 +475,15 @@ page_changed_cb (EvDocumentModel  *model,
 static void
 initialize_children (EvViewAccessible *self)
 {
-	gint i;
-	EvPageAccessible *child;
 	gint n_pages;
 	EvDocument *ev_document;
 
 	ev_document = ev_document_model_get_document (self->priv->model);
 	n_pages = ev_document_get_n_pages (ev_document);
 
-	self->priv->children = g_ptr_array_new_full (n_pages, (GDestroyNotify) g_object_unref);
-	for (i = 0; i < n_pages; i++) {
-		child = ev_page_accessible_new (self, i);
-		g_ptr_array_add (self->priv->children, child);
-	}
+	/* Page accessibles are created when they are first needed */
+	self->priv->children = g_ptr_array_new_full (n_pages, (GDestroyNotify) page_accessible_free);
+	g_ptr_array_set_size (self->priv->children, n_pages);
 
         /* When a document is reloaded, it may have less pages.
          * We need to update the end page accordingly to avoid
@@ -470,8 +556,11 @@ ev_view_accessible_focus_changed (GtkWidget        *widget,
 	if (self->priv->children == NULL || self->priv->children->len == 0)
 		return FALSE;
 
-	page_accessible = g_ptr_array_index (self->priv->children,
-					     get_relevant_page (EV_VIEW (widget)));
+	page_accessible = ATK_OBJECT (get_page_accessible (self,
+							   get_relevant_page (EV_VIEW (widget))));
+	if (page_accessible == NULL)
+		return FALSE;
+
 	atk_object_notify_state_change (page_accessible,
 					ATK_STATE_FOCUSED, event->in);
 
@@ -590,26 +679,34 @@ ev_view_accessible_set_page_range (EvViewAccessible *accessible,
 				   gint end)
 {
 	gint i;
+	gint previous_start, previous_end;
 	AtkObject *page;
 
 	g_return_if_fail (EV_IS_VIEW_ACCESSIBLE (accessible));
 
 	for (i = accessible->priv->start_page; i <= accessible->priv->end_page; i++) {
 		if (i < start || i > end) {
-			page = g_ptr_array_index (accessible->priv->children, i);
-			atk_object_notify_state_change (page, ATK_STATE_SHOWING, FALSE);
+			page = ATK_OBJECT (peek_page_accessible (accessible, i));
+			if (page)
+				atk_object_notify_state_change (page, ATK_STATE_SHOWING, FALSE);
 		}
 	}
 
 	for (i = start; i <= end; i++) {
 		if (i < accessible->priv->start_page || i > accessible->priv->end_page) {
-			page = g_ptr_array_index (accessible->priv->children, i);
-			atk_object_notify_state_change (page, ATK_STATE_SHOWING, TRUE);
+			page = ATK_OBJECT (get_page_accessible (accessible, i));
+			if (page)
+				atk_object_notify_state_change (page, ATK_STATE_SHOWING, TRUE);
 		}
 	}
 
+	previous_start = accessible->priv->start_page;
+	previous_end = accessible->priv->end_page;
 	accessible->priv->start_page = start;
 	accessible->priv->end_page = end;
+
+	if (accessible->priv->children)
+		release_unused_children (accessible, previous_start, previous_end);
 }
 
 void
@@ -627,7 +724,11 @@ ev_view_accessible_set_focused_element (EvViewAccessible *accessible,
 	if (!new_focus || new_focus_page == -1)
 		return;
 
-	page = g_ptr_array_index (accessible->priv->children, new_focus_page);
+	page = get_page_accessible (accessible, new_focus_page);
+	if (page == NULL)
+		return;
+
+	accessible->priv->focused_page = new_focus_page;
 	accessible->priv->focused_element = ev_page_accessible_get_accessible_for_mapping (page, new_focus);
 	if (accessible->priv->focused_element)
 		atk_object_notify_state_change (accessible->priv->focused_element, ATK_STATE_FOCUSED, TRUE);
@@ -640,6 +741,8 @@ ev_view_accessible_update_element_state (EvViewAccessible *accessible,
 {
 	EvPageAccessible *page;
 
-	page = g_ptr_array_index (accessible->priv->children, element_page);
-	ev_page_accessible_update_element_state (page, element);
+	/* Pages without an accessible don't have element accessibles either */
+	page = peek_page_accessible (accessible, element_page);
+	if (page)
+		ev_page_accessible_update_element_state (page, element);
 }
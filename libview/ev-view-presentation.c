@@ -89,9 +89,11 @@ struct _EvViewPresentation
 	/* Links */
 	EvPageCache           *page_cache;
 
-	EvJob *prev_job;
-	EvJob *curr_job;
-	EvJob *next_job;
+	/* Slides rendered around the current one, indexed by page */
+	GHashTable            *jobs;
+	gsize                  cache_size;
+	/* Direction of the last page change, 1 forward or -1 backward */
+	gint                   direction;
 };
 
 struct _EvViewPresentationClass
@@ -114,6 +116,10 @@ static void ev_view_presentation_set_cursor_for_location (EvViewPresentation *pv
 
 #define HIDE_CURSOR_TIMEOUT 5
 
+#define DEFAULT_CACHE_SIZE   (52428800) /* 50MB */
+#define MIN_PRELOADED_SLIDES 3
+#define MAX_PRELOADED_SLIDES 16
+
 G_DEFINE_TYPE (EvViewPresentation, ev_view_presentation, GTK_TYPE_WIDGET)
 
 static void
@@ -274,7 +280,15 @@ static void
 ev_view_presentation_transition_animation_frame (EvViewPresentation *pview,
 						 gdouble             progress)
 {
-	gtk_widget_queue_draw (GTK_WIDGET (pview));
+	GdkRectangle page_area;
+	GdkRectangle area;
+
+	/* Only redraw what changed since the last frame */
+	ev_view_presentation_get_page_area (pview, &page_area);
+	ev_transition_animation_get_damage_area (pview->animation, page_area, &area);
+	gtk_widget_queue_draw_area (GTK_WIDGET (pview),
+				    area.x, area.y,
+				    area.width, area.height);
 }
 
 static cairo_surface_t *
@@ -300,6 +314,16 @@ get_surface_from_job (EvViewPresentation *pview,
         return surface;
 }
 
+static EvJob *
+ev_view_presentation_get_job (EvViewPresentation *pview,
+			      guint               page)
+{
+	if (!pview->jobs)
+		return NULL;
+
+	return g_hash_table_lookup (pview->jobs, GUINT_TO_POINTER (page));
+}
+
 static void
 ev_view_presentation_animation_start (EvViewPresentation *pview,
 				      gint                new_page)
@@ -307,7 +331,6 @@ ev_view_presentation_animation_start (EvViewPresentation *pview,
 	EvTransitionEffect *effect = NULL;
 	EvJob		   *job;
 	cairo_surface_t    *surface;
-	gint                jump;
 
 	if (!pview->enable_animations)
 		return;
@@ -321,20 +344,18 @@ ev_view_presentation_animation_start (EvViewPresentation *pview,
 		return;
 
 	pview->animation = ev_transition_animation_new (effect);
+	ev_timeline_set_widget (EV_TIMELINE (pview->animation), GTK_WIDGET (pview));
 
-	surface = pview->curr_job ? EV_JOB_RENDER (pview->curr_job)->surface : NULL;
+	job = ev_view_presentation_get_job (pview, pview->current_page);
+	surface = job ? EV_JOB_RENDER (job)->surface : NULL;
 	ev_transition_animation_set_origin_surface (pview->animation,
 						    surface != NULL ?
 						    surface : pview->current_surface);
 
-	jump = new_page - pview->current_page;
-	if (jump == -1)
-		job = pview->prev_job;
-	else if (jump == 1)
-		job = pview->next_job;
-	else
-		job = NULL;
-	surface = get_surface_from_job (pview, job);
+	/* Any slide inside the lookahead window is usually rendered
+	 * already, so the destination is available right away.
+	 */
+	surface = get_surface_from_job (pview, ev_view_presentation_get_job (pview, new_page));
 	if (surface)
 		ev_transition_animation_set_dest_surface (pview->animation, surface);
 
@@ -356,7 +377,7 @@ job_finished_cb (EvJob              *job,
 	if (pview->inverted_colors)
 		ev_document_misc_invert_surface (job_render->surface);
 
-	if (job != pview->curr_job)
+	if (job != ev_view_presentation_get_job (pview, pview->current_page))
 		return;
 
 	if (pview->animation) {
@@ -412,27 +433,84 @@ ev_view_presentation_delete_job (EvViewPresentation *pview,
 static void
 ev_view_presentation_reset_jobs (EvViewPresentation *pview)
 {
-        if (pview->curr_job) {
-                ev_view_presentation_delete_job (pview, pview->curr_job);
-                pview->curr_job = NULL;
-        }
+	GHashTableIter iter;
+	gpointer       job;
 
-        if (pview->prev_job) {
-                ev_view_presentation_delete_job (pview, pview->prev_job);
-                pview->prev_job = NULL;
-        }
+	if (!pview->jobs)
+		return;
 
-        if (pview->next_job) {
-                ev_view_presentation_delete_job (pview, pview->next_job);
-                pview->next_job = NULL;
-        }
+	g_hash_table_iter_init (&iter, pview->jobs);
+	while (g_hash_table_iter_next (&iter, NULL, &job))
+		ev_view_presentation_delete_job (pview, EV_JOB (job));
+	g_hash_table_remove_all (pview->jobs);
+}
+
+/* Number of slides kept rendered around @page so that they fit in
+ * cache_size. Most of the window is spent on the slides in the direction
+ * of the last page change, forward at first since that's the direction
+ * talks usually go.
+ */
+static void
+ev_view_presentation_get_preload_range (EvViewPresentation *pview,
+					guint               page,
+					gint               *first,
+					gint               *last)
+{
+	gint  view_width, view_height;
+	gsize slide_size;
+	guint n_slides;
+	guint n_behind;
+	gint  n_pages;
+
+	ev_view_presentation_get_view_size (pview, page, &view_width, &view_height);
+#ifdef HAVE_HIDPI_SUPPORT
+	{
+		gint device_scale = gtk_widget_get_scale_factor (GTK_WIDGET (pview));
+		view_width *= device_scale;
+		view_height *= device_scale;
+	}
+#endif
+	slide_size = (gsize) MAX (view_width, 1) * MAX (view_height, 1) * 4;
+	n_slides = CLAMP (pview->cache_size / slide_size,
+			  MIN_PRELOADED_SLIDES, MAX_PRELOADED_SLIDES);
+	n_behind = 1 + (n_slides - MIN_PRELOADED_SLIDES) / 4;
+
+	n_pages = ev_document_get_n_pages (pview->document);
+	if (pview->direction < 0) {
+		*first = MAX ((gint) page - (gint) (n_slides - n_behind - 1), 0);
+		*last = MIN ((gint) page + (gint) n_behind, n_pages - 1);
+	} else {
+		*first = MAX ((gint) page - (gint) n_behind, 0);
+		*last = MIN ((gint) page + (gint) (n_slides - n_behind - 1), n_pages - 1);
+	}
+}
+
+static void
+ev_view_presentation_preload_page (EvViewPresentation *pview,
+				   gint                page,
+				   EvJobPriority       priority)
+{
+	EvJob *job;
+
+	job = ev_view_presentation_get_job (pview, page);
+	if (job) {
+		ev_job_scheduler_update_job (job, priority);
+		return;
+	}
+
+	job = ev_view_presentation_schedule_new_job (pview, page, priority);
+	if (job)
+		g_hash_table_insert (pview->jobs, GINT_TO_POINTER (page), job);
 }
 
 static void
 ev_view_presentation_update_current_page (EvViewPresentation *pview,
 					  guint               page)
 {
-	gint jump;
+	GHashTableIter iter;
+	gpointer       key, value;
+	EvJob         *job;
+	gint           first, last, i;
 
 	if (page < 0 || page >= ev_document_get_n_pages (pview->document))
 		return;
@@ -440,82 +518,32 @@ ev_view_presentation_update_current_page (EvViewPresentation *pview,
 	ev_view_presentation_animation_cancel (pview);
 	ev_view_presentation_animation_start (pview, page);
 
-	jump = page - pview->current_page;
-
-	switch (jump) {
-	case 0:
-		if (!pview->curr_job)
-			pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		if (!pview->next_job)
-			pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_HIGH);
-		if (!pview->prev_job)
-			pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_LOW);
-		break;
-	case -1:
-		ev_view_presentation_delete_job (pview, pview->next_job);
-		pview->next_job = pview->curr_job;
-		pview->curr_job = pview->prev_job;
-
-		if (!pview->curr_job)
-			pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		else
-			ev_job_scheduler_update_job (pview->curr_job, EV_JOB_PRIORITY_URGENT);
-		pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_HIGH);
-		ev_job_scheduler_update_job (pview->next_job, EV_JOB_PRIORITY_LOW);
+	if (page != pview->current_page)
+		pview->direction = page < pview->current_page ? -1 : 1;
+	ev_view_presentation_get_preload_range (pview, page, &first, &last);
 
-		break;
-	case 1:
-		ev_view_presentation_delete_job (pview, pview->prev_job);
-		pview->prev_job = pview->curr_job;
-		pview->curr_job = pview->next_job;
-
-		if (!pview->curr_job)
-			pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		else
-			ev_job_scheduler_update_job (pview->curr_job, EV_JOB_PRIORITY_URGENT);
-		pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_HIGH);
-		ev_job_scheduler_update_job (pview->prev_job, EV_JOB_PRIORITY_LOW);
+	/* Drop the slides that are now outside the lookahead window */
+	g_hash_table_iter_init (&iter, pview->jobs);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		gint job_page = GPOINTER_TO_INT (key);
 
-		break;
-	case -2:
-		ev_view_presentation_delete_job (pview, pview->next_job);
-		ev_view_presentation_delete_job (pview, pview->curr_job);
-		pview->next_job = pview->prev_job;
-
-		pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_HIGH);
-		if (!pview->next_job)
-			pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_LOW);
-		else
-			ev_job_scheduler_update_job (pview->next_job, EV_JOB_PRIORITY_LOW);
-		break;
-	case 2:
-		ev_view_presentation_delete_job (pview, pview->prev_job);
-		ev_view_presentation_delete_job (pview, pview->curr_job);
-		pview->prev_job = pview->next_job;
-
-		pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_HIGH);
-		if (!pview->prev_job)
-			pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_LOW);
-		else
-			ev_job_scheduler_update_job (pview->prev_job, EV_JOB_PRIORITY_LOW);
-		break;
-	default:
-		ev_view_presentation_delete_job (pview, pview->prev_job);
-		ev_view_presentation_delete_job (pview, pview->curr_job);
-		ev_view_presentation_delete_job (pview, pview->next_job);
-
-		pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		if (jump > 0) {
-			pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_HIGH);
-			pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_LOW);
-		} else {
-			pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_HIGH);
-			pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_LOW);
+		if (job_page < first || job_page > last) {
+			ev_view_presentation_delete_job (pview, EV_JOB (value));
+			g_hash_table_iter_remove (&iter);
 		}
 	}
 
+	/* Schedule by distance so the closest slides are rendered first */
+	ev_view_presentation_preload_page (pview, page, EV_JOB_PRIORITY_URGENT);
+	ev_view_presentation_preload_page (pview, (gint) page + pview->direction, EV_JOB_PRIORITY_HIGH);
+	ev_view_presentation_preload_page (pview, (gint) page - pview->direction, EV_JOB_PRIORITY_LOW);
+	for (i = 2; (gint) page + i <= last || (gint) page - i >= first; i++) {
+		if ((gint) page + i <= last)
+			ev_view_presentation_preload_page (pview, page + i, EV_JOB_PRIORITY_LOW);
+		if ((gint) page - i >= first)
+			ev_view_presentation_preload_page (pview, page - i, EV_JOB_PRIORITY_LOW);
+	}
+
 	if (pview->current_page != page) {
 		pview->current_page = page;
 		g_object_notify (G_OBJECT (pview), "current-page");
@@ -531,7 +559,8 @@ ev_view_presentation_update_current_page (EvViewPresentation *pview,
 		ev_view_presentation_set_cursor_for_location (pview, x, y);
 	}
 
-	if (EV_JOB_RENDER (pview->curr_job)->surface)
+	job = ev_view_presentation_get_job (pview, page);
+	if (job && EV_JOB_RENDER (job)->surface)
 		gtk_widget_queue_draw (GTK_WIDGET (pview));
 }
 
@@ -986,6 +1015,7 @@ ev_view_presentation_dispose (GObject *object)
 	ev_view_presentation_transition_stop (pview);
 	ev_view_presentation_hide_cursor_timeout_stop (pview);
         ev_view_presentation_reset_jobs (pview);
+	g_clear_pointer (&pview->jobs, g_hash_table_destroy);
 
 	if (pview->current_surface) {
 		cairo_surface_destroy (pview->current_surface);
@@ -1103,7 +1133,8 @@ ev_view_presentation_draw (GtkWidget *widget,
 		return TRUE;
 	}
 
-	surface = get_surface_from_job (pview, pview->curr_job);
+	surface = get_surface_from_job (pview,
+					ev_view_presentation_get_job (pview, pview->current_page));
 	if (surface) {
 		ev_view_presentation_update_current_surface (pview, surface);
 	} else if (pview->current_surface) {
@@ -1612,6 +1643,9 @@ ev_view_presentation_init (EvViewPresentation *pview)
 {
 	gtk_widget_set_can_focus (GTK_WIDGET (pview), TRUE);
         pview->is_constructing = TRUE;
+	pview->jobs = g_hash_table_new (g_direct_hash, g_direct_equal);
+	pview->cache_size = DEFAULT_CACHE_SIZE;
+	pview->direction = 1;
 }
 
 GtkWidget *
@@ -1663,3 +1697,26 @@ ev_view_presentation_get_rotation (EvViewPresentation *pview)
 {
         return pview->rotation;
 }
+
+/**
+ * ev_view_presentation_set_cache_size:
+ * @pview: a #EvViewPresentation
+ * @cache_size: size in bytes
+ *
+ * Sets the maximum size in bytes used to keep the slides around the
+ * current one rendered ahead of time, so that moving to them and their
+ * transitions don't wait for a render. The current slide and its
+ * immediate neighbours are always rendered regardless of this limit.
+ *
+ * The new size is applied the next time the current page changes.
+ *
+ * Since: 43
+ */
+void
+ev_view_presentation_set_cache_size (EvViewPresentation *pview,
+				     gsize               cache_size)
+{
+	g_return_if_fail (EV_IS_VIEW_PRESENTATION (pview));
+
+	pview->cache_size = cache_size;
+}
@@ -59,5 +59,8 @@ void            ev_view_presentation_set_rotation     (EvViewPresentation *pview
                                                        gint                rotation);
 EV_PUBLIC
 guint           ev_view_presentation_get_rotation     (EvViewPresentation *pview);
+EV_PUBLIC
+void            ev_view_presentation_set_cache_size   (EvViewPresentation *pview,
+                                                       gsize               cache_size);
 
 G_END_DECLS
@@ -7761,8 +7761,6 @@ draw_surface (cairo_t 	      *cr,
 
 		scale_x = (gdouble)target_width / width;
 		scale_y = (gdouble)target_height / height;
-		cairo_pattern_set_filter (cairo_get_source (cr),
-					  CAIRO_FILTER_NEAREST);
 		cairo_scale (cr, scale_x, scale_y);
 
 		offset_x /= scale_x;
@@ -7770,6 +7768,12 @@ draw_surface (cairo_t 	      *cr,
 	}
 
 	cairo_set_source_surface (cr, surface, -offset_x, -offset_y);
+	/* The surface is scaled while the render at the new scale is
+	 * pending, which can take a while during a pinch zoom. The filter
+	 * has to be set on the surface pattern to be used at all.
+	 */
+	if (width != target_width || height != target_height)
+		cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_BILINEAR);
 	cairo_paint (cr);
 	cairo_restore (cr);
 }
@@ -8784,6 +8788,22 @@ zoom_gesture_begin_cb (GtkGesture       *gesture,
 		       EvView           *view)
 {
 	view->prev_zoom_gesture_scale = 1;
+
+	if (view->pixbuf_cache)
+		ev_pixbuf_cache_set_zooming (view->pixbuf_cache, TRUE);
+}
+
+static void
+zoom_gesture_end_cb (GtkGesture       *gesture,
+		     GdkEventSequence *sequence,
+		     EvView           *view)
+{
+	if (!view->pixbuf_cache)
+		return;
+
+	/* Render the pages at the scale the gesture settled on */
+	ev_pixbuf_cache_set_zooming (view->pixbuf_cache, FALSE);
+	view_update_range_and_current_page (view);
 }
 
 static void
@@ -8884,6 +8904,8 @@ ev_view_init (EvView *view)
 			  G_CALLBACK (zoom_gesture_begin_cb), view);
 	g_signal_connect (view->zoom_gesture, "scale-changed",
 			  G_CALLBACK (zoom_gesture_scale_changed_cb), view);
+	g_signal_connect (view->zoom_gesture, "end",
+			  G_CALLBACK (zoom_gesture_end_cb), view);
 }
 
 /*** Callbacks ***/
@@ -9052,7 +9074,10 @@ setup_caches (EvView *view)
 	gboolean inverted_colors;
 
 	view->height_to_page_cache = ev_view_get_height_to_page_cache (view);
-	view->pixbuf_cache = ev_pixbuf_cache_new (GTK_WIDGET (view), view->model, view->pixbuf_cache_size);
+	if (!view->pixbuf_cache) {
+		view->pixbuf_cache = ev_pixbuf_cache_new (GTK_WIDGET (view), view->model, view->pixbuf_cache_size);
+		g_signal_connect (view->pixbuf_cache, "job-finished", G_CALLBACK (job_finished_cb), view);
+	}
 	view->page_cache = ev_page_cache_new (view->document);
 
 	ev_page_cache_set_flags (view->page_cache,
@@ -9064,7 +9089,6 @@ setup_caches (EvView *view)
 
 	inverted_colors = ev_document_model_get_inverted_colors (view->model);
 	ev_pixbuf_cache_set_inverted_colors (view->pixbuf_cache, inverted_colors);
-	g_signal_connect (view->pixbuf_cache, "job-finished", G_CALLBACK (job_finished_cb), view);
 }
 
 static void
@@ -9182,10 +9206,22 @@ ev_view_document_changed_cb (EvDocumentModel *model,
 	EvDocument *document = ev_document_model_get_document (model);
 
 	if (document != view->document) {
+		EvPixbufCache *pixbuf_cache = NULL;
 		gint current_page;
 
 		ev_view_remove_all (view);
+
+		/* When the document is reloaded, keep the rendered pages
+		 * that didn't change.
+		 */
+		if (view->pixbuf_cache && document &&
+		    ev_document_get_n_pages (document) > 0 &&
+		    ev_document_check_dimensions (document)) {
+			pixbuf_cache = g_object_ref (view->pixbuf_cache);
+			ev_pixbuf_cache_reload_document (pixbuf_cache, document);
+		}
 		clear_caches (view);
+		view->pixbuf_cache = pixbuf_cache;
 
 		if (view->document) {
 			g_object_unref (view->document);
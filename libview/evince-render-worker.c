@@ -0,0 +1,334 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Helper process rendering the pages of a document for the viewer,
+ * see ev-render-worker.h for the protocol.
+ */
+
+#include <config.h>
+
+#include <locale.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gio/gio.h>
+#include <gio/gunixfdmessage.h>
+
+#include <evince-document.h>
+
+#include "ev-render-worker.h"
+
+static gboolean
+send_reply (GSocket             *socket,
+	    EvRenderWorkerReply *reply,
+	    gint                 fd)
+{
+	GOutputVector          vector = { reply, sizeof (EvRenderWorkerReply) };
+	GSocketControlMessage *message = NULL;
+	gssize                 len;
+	GError                *error = NULL;
+
+	if (fd != -1) {
+		message = g_unix_fd_message_new ();
+		if (!g_unix_fd_message_append_fd (G_UNIX_FD_MESSAGE (message), fd, &error)) {
+			g_printerr ("Failed to send rendered page: %s\n", error->message);
+			g_error_free (error);
+			g_object_unref (message);
+
+			return FALSE;
+		}
+	}
+
+	len = g_socket_send_message (socket, NULL, &vector, 1,
+				     message ? &message : NULL,
+				     message ? 1 : 0,
+				     0, NULL, &error);
+	g_clear_object (&message);
+	if (len < 0) {
+		g_printerr ("Failed to send reply: %s\n", error->message);
+		g_error_free (error);
+	}
+
+	return len == sizeof (EvRenderWorkerReply);
+}
+
+static gint
+create_shared_memory (gsize size)
+{
+	gint fd;
+
+#ifdef HAVE_MEMFD_CREATE
+	fd = memfd_create ("evince-render-worker", MFD_CLOEXEC);
+#else
+	gchar *path;
+
+	fd = g_file_open_tmp ("evince-render-worker-XXXXXX", &path, NULL);
+	if (fd != -1) {
+		unlink (path);
+		g_free (path);
+	}
+#endif
+	if (fd == -1)
+		return -1;
+
+	if (ftruncate (fd, size) < 0) {
+		close (fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/* Maps a shared memory file that the viewer maps directly as the pixel
+ * data of its surface, and paints the rendered page into it.
+ */
+static gint
+surface_to_shared_memory (cairo_surface_t     *surface,
+			  EvRenderWorkerReply *reply)
+{
+	cairo_surface_t *shared;
+	cairo_format_t   format = CAIRO_FORMAT_ARGB32;
+	cairo_t         *cr;
+	guchar          *data;
+	gsize            size;
+	gint             width, height, stride;
+	gint             fd;
+
+	if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE) {
+		format = cairo_image_surface_get_format (surface);
+		width = cairo_image_surface_get_width (surface);
+		height = cairo_image_surface_get_height (surface);
+	} else {
+		gdouble x1, y1, x2, y2;
+
+		cr = cairo_create (surface);
+		cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+		cairo_destroy (cr);
+
+		width = x2 - x1;
+		height = y2 - y1;
+	}
+
+	stride = cairo_format_stride_for_width (format, width);
+	if (width <= 0 || height <= 0 || stride <= 0)
+		return -1;
+
+	size = (gsize) stride * height;
+	fd = create_shared_memory (size);
+	if (fd == -1)
+		return -1;
+
+	data = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		close (fd);
+		return -1;
+	}
+
+	shared = cairo_image_surface_create_for_data (data, format, width, height, stride);
+	cr = cairo_create (shared);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface (cr, surface, 0, 0);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+	cairo_surface_finish (shared);
+	cairo_surface_destroy (shared);
+	munmap (data, size);
+
+	reply->format = format;
+	reply->width = width;
+	reply->height = height;
+	reply->stride = stride;
+	reply->x_scale = reply->y_scale = 1.;
+#ifdef HAVE_HIDPI_SUPPORT
+	cairo_surface_get_device_scale (surface, &reply->x_scale, &reply->y_scale);
+#endif
+
+	return fd;
+}
+
+static gint
+render_page (EvDocument                  *document,
+	     const EvRenderWorkerRequest *request,
+	     EvRenderWorkerReply         *reply)
+{
+	EvPage          *page;
+	EvRenderContext *rc;
+	cairo_surface_t *surface;
+	gint             fd = -1;
+
+	if (request->page < 0 || request->page >= ev_document_get_n_pages (document))
+		return -1;
+
+	ev_document_doc_mutex_lock ();
+	ev_document_fc_mutex_lock ();
+
+	page = ev_document_get_page (document, request->page);
+	rc = ev_render_context_new (page, request->rotation, request->scale);
+	ev_render_context_set_target_size (rc, request->target_width, request->target_height);
+	if (request->has_region) {
+		cairo_rectangle_int_t region;
+
+		region.x = request->region_x;
+		region.y = request->region_y;
+		region.width = request->region_width;
+		region.height = request->region_height;
+		ev_render_context_set_region (rc, &region);
+	}
+	g_object_unref (page);
+
+	surface = ev_document_render (document, rc);
+	g_object_unref (rc);
+
+	ev_document_fc_mutex_unlock ();
+	ev_document_doc_mutex_unlock ();
+
+	if (surface && cairo_surface_status (surface) == CAIRO_STATUS_SUCCESS)
+		fd = surface_to_shared_memory (surface, reply);
+	g_clear_pointer (&surface, cairo_surface_destroy);
+
+	return fd;
+}
+
+/* Whether the file at @uri is still the one the viewer loaded */
+static gboolean
+file_is_unchanged (const gchar *uri,
+		   gint64       mtime,
+		   goffset      size)
+{
+	GFile     *file;
+	GFileInfo *info;
+	gboolean   retval;
+
+	file = g_file_new_for_uri (uri);
+	info = g_file_query_info (file,
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE,
+				  G_FILE_QUERY_INFO_NONE, NULL, NULL);
+	g_object_unref (file);
+	if (!info)
+		return FALSE;
+
+	retval = g_file_info_get_size (info) == size &&
+		g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+		g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC) == mtime;
+	g_object_unref (info);
+
+	return retval;
+}
+
+int
+main (int argc, char *argv[])
+{
+	EvDocument          *document;
+	GSocket             *socket;
+	EvRenderWorkerReply  reply = { 0 };
+	gint64               mtime;
+	goffset              size;
+	GError              *error = NULL;
+
+	setlocale (LC_ALL, "");
+
+	if (argc != 4) {
+		g_printerr ("Usage: %s URI MTIME SIZE\n", argv[0]);
+		return -1;
+	}
+
+	mtime = g_ascii_strtoll (argv[2], NULL, 10);
+	size = g_ascii_strtoll (argv[3], NULL, 10);
+
+	socket = g_socket_new_from_fd (EV_RENDER_WORKER_SOCKET_FD, &error);
+	if (!socket) {
+		g_printerr ("Failed to open render worker socket: %s\n", error->message);
+		g_error_free (error);
+
+		return -1;
+	}
+
+	if (!ev_init ()) {
+		g_object_unref (socket);
+		return -1;
+	}
+
+	/* The file is checked again after loading it, in case it
+	 * changed while it was being loaded.
+	 */
+	document = NULL;
+	reply.status = EV_RENDER_WORKER_STATUS_FILE_CHANGED;
+	if (file_is_unchanged (argv[1], mtime, size)) {
+		document = ev_document_factory_get_document (argv[1], &error);
+		if (!document) {
+			g_printerr ("Error loading document: %s\n", error->message);
+			g_error_free (error);
+			reply.status = EV_RENDER_WORKER_STATUS_LOAD_FAILED;
+		} else if (!file_is_unchanged (argv[1], mtime, size)) {
+			g_clear_object (&document);
+		}
+	}
+
+	if (!document) {
+		if (reply.status == EV_RENDER_WORKER_STATUS_FILE_CHANGED)
+			g_printerr ("Document %s changed since the viewer loaded it\n", argv[1]);
+
+		send_reply (socket, &reply, -1);
+		g_object_unref (socket);
+		ev_shutdown ();
+
+		return -2;
+	}
+
+	reply.status = EV_RENDER_WORKER_STATUS_OK;
+	if (!send_reply (socket, &reply, -1)) {
+		g_object_unref (document);
+		g_object_unref (socket);
+		ev_shutdown ();
+
+		return -2;
+	}
+
+	/* The viewer closes the socket when it doesn't need the worker
+	 * anymore, and kills it when rendering a page takes too long.
+	 */
+	while (TRUE) {
+		EvRenderWorkerRequest request;
+		gssize                len;
+		gint                  fd;
+
+		len = g_socket_receive (socket, (gchar *) &request, sizeof (request), NULL, NULL);
+		if (len != sizeof (request))
+			break;
+
+		memset (&reply, 0, sizeof (reply));
+		fd = render_page (document, &request, &reply);
+		reply.status = fd != -1 ? EV_RENDER_WORKER_STATUS_OK : EV_RENDER_WORKER_STATUS_RENDER_FAILED;
+		if (!send_reply (socket, &reply, fd)) {
+			if (fd != -1)
+				close (fd);
+			break;
+		}
+
+		if (fd != -1)
+			close (fd);
+	}
+
+	g_object_unref (document);
+	g_object_unref (socket);
+	ev_shutdown ();
+
+	return 0;
+}
@@ -107,7 +107,7 @@ ev_properties_get_pages (NautilusPropertyPageProvider *provider,
 	if (!document)
 		goto end;
 
-	ev_document_load (document, uri, &error);
+	ev_document_load_full (document, uri, EV_DOCUMENT_LOAD_FLAG_PROBE, &error);
 	if (error) {
 		g_error_free (error);
 		goto end;
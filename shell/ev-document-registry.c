@@ -0,0 +1,188 @@
+/* ev-document-registry.c
+ *  this file is part of evince, a gnome document viewer
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include "ev-document-registry.h"
+
+typedef struct {
+	gchar    *uri;
+	gint64    mtime;
+	GWeakRef  document;
+} RegistryEntry;
+
+/* The registry doesn't keep the documents alive, and documents can be
+ * finalized from the job threads, so entries only hold weak references
+ * and entries whose document is gone are dropped when they are found.
+ */
+static GHashTable *registry = NULL;
+static GMutex      registry_mutex;
+
+static gchar *
+canonicalize_uri (const gchar *uri)
+{
+	GFile *file;
+	gchar *retval;
+
+	file = g_file_new_for_uri (uri);
+	retval = g_file_get_uri (file);
+	g_object_unref (file);
+
+	return retval;
+}
+
+static void
+registry_entry_free (RegistryEntry *entry)
+{
+	g_weak_ref_clear (&entry->document);
+	g_free (entry->uri);
+	g_slice_free (RegistryEntry, entry);
+}
+
+static gboolean
+registry_entry_is_stale (gpointer       key,
+			 RegistryEntry *entry,
+			 gpointer       user_data)
+{
+	GObject *document;
+
+	document = g_weak_ref_get (&entry->document);
+	if (!document)
+		return TRUE;
+
+	g_object_unref (document);
+
+	return FALSE;
+}
+
+/**
+ * ev_document_registry_get_mtime:
+ * @uri: the uri of a file
+ *
+ * Returns: the modification time of @uri in microseconds, or 0 when it
+ *   can't be known cheaply, which is always the case for non local files.
+ */
+gint64
+ev_document_registry_get_mtime (const gchar *uri)
+{
+	GFile     *file;
+	GFileInfo *info;
+	gint64     mtime = 0;
+
+	file = g_file_new_for_uri (uri);
+	if (!g_file_is_native (file)) {
+		g_object_unref (file);
+		return 0;
+	}
+
+	info = g_file_query_info (file,
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+				  G_FILE_QUERY_INFO_NONE,
+				  NULL, NULL);
+	if (info) {
+		mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+			g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+		g_object_unref (info);
+	}
+	g_object_unref (file);
+
+	return mtime;
+}
+
+/**
+ * ev_document_registry_lookup:
+ * @uri: the uri of a file
+ * @mtime: the modification time of @uri, as returned by ev_document_registry_get_mtime()
+ *
+ * Returns: (transfer full) (nullable): the document loaded from @uri when
+ *   it had @mtime as modification time, or %NULL if there isn't any or it
+ *   has unsaved changes.
+ */
+EvDocument *
+ev_document_registry_lookup (const gchar *uri,
+			     gint64       mtime)
+{
+	RegistryEntry *entry;
+	EvDocument    *document = NULL;
+	gchar         *key;
+
+	if (mtime == 0)
+		return NULL;
+
+	key = canonicalize_uri (uri);
+
+	g_mutex_lock (&registry_mutex);
+	entry = registry ? g_hash_table_lookup (registry, key) : NULL;
+	if (entry) {
+		document = g_weak_ref_get (&entry->document);
+		if (!document)
+			g_hash_table_remove (registry, key);
+		else if (entry->mtime != mtime)
+			g_clear_object (&document);
+	}
+	g_mutex_unlock (&registry_mutex);
+
+	g_free (key);
+
+	if (document && ev_document_has_unsaved_changes (document))
+		g_clear_object (&document);
+
+	return document;
+}
+
+/**
+ * ev_document_registry_add:
+ * @uri: the uri @document was loaded from
+ * @mtime: the modification time of @uri before @document was loaded
+ * @document: an #EvDocument
+ *
+ * Makes @document available to other windows opening @uri, replacing
+ * any document previously loaded from it.
+ */
+void
+ev_document_registry_add (const gchar *uri,
+			  gint64       mtime,
+			  EvDocument  *document)
+{
+	RegistryEntry *entry;
+
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	if (mtime == 0)
+		return;
+
+	entry = g_slice_new (RegistryEntry);
+	entry->uri = canonicalize_uri (uri);
+	entry->mtime = mtime;
+	g_weak_ref_init (&entry->document, document);
+
+	g_mutex_lock (&registry_mutex);
+	if (!registry) {
+		registry = g_hash_table_new_full (g_str_hash, g_str_equal,
+						  NULL,
+						  (GDestroyNotify) registry_entry_free);
+	} else {
+		g_hash_table_foreach_remove (registry, (GHRFunc) registry_entry_is_stale, NULL);
+	}
+
+	g_hash_table_replace (registry, entry->uri, entry);
+	g_mutex_unlock (&registry_mutex);
+}
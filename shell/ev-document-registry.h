@@ -0,0 +1,38 @@
+/* ev-document-registry.h
+ *  this file is part of evince, a gnome document viewer
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* The document registry keeps track of the documents loaded by the
+ * windows of the process, so that a window opening or reloading a file
+ * that another window has already loaded can share its EvDocument
+ * instead of loading it again.
+ */
+
+#pragma once
+
+#include <evince-document.h>
+
+G_BEGIN_DECLS
+
+gint64      ev_document_registry_get_mtime (const gchar *uri);
+EvDocument *ev_document_registry_lookup    (const gchar *uri,
+					    gint64       mtime);
+void        ev_document_registry_add       (const gchar *uri,
+					    gint64       mtime,
+					    EvDocument  *document);
+
+G_END_DECLS
@@ -168,13 +168,11 @@ static void
 job_fonts_updated_cb (EvJobFonts *job, gdouble progress, EvPropertiesFonts *properties)
 {
 	GtkTreeModel *model;
-	EvDocumentFonts *document_fonts = EV_DOCUMENT_FONTS (properties->document);
 
 	update_progress_label (properties->fonts_progress_label, progress);
 
 	model = gtk_tree_view_get_model (properties->fonts_treeview);
-	/* Document lock is already held by the jop */
-	ev_document_fonts_fill_model (document_fonts, model);
+	ev_job_fonts_fill_model (job, model);
 }
 
 void
@@ -443,6 +443,9 @@ static void
 load_document_and_get_document_info (GetDocumentInfoAsyncData *data)
 {
         data->job = EV_JOB (ev_job_load_new (data->uri));
+        /* Only the info and the first page are needed */
+        ev_job_load_set_load_flags (EV_JOB_LOAD (data->job),
+                                    EV_DOCUMENT_LOAD_FLAG_PROBE);
         g_signal_connect (data->job, "finished",
                           G_CALLBACK (document_load_job_completed_callback),
                           data);
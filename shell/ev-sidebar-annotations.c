@@ -59,6 +59,7 @@ struct _EvSidebarAnnotationsPrivate {
 	GtkWidget   *popup;
 
 	EvJob       *job;
+	GtkTreeStore *model;
 	guint        selection_changed_id;
 };
 
@@ -93,6 +94,13 @@ ev_sidebar_annotations_dispose (GObject *object)
 		priv->document = NULL;
 	}
 
+	if (priv->job) {
+		g_signal_handlers_disconnect_by_data (priv->job, sidebar_annots);
+		ev_job_cancel (priv->job);
+		g_clear_object (&priv->job);
+	}
+	g_clear_object (&priv->model);
+
 	g_clear_object (&priv->popup_model);
 	G_OBJECT_CLASS (ev_sidebar_annotations_parent_class)->dispose (object);
 }
@@ -348,28 +356,10 @@ sidebar_tree_button_press_cb (GtkTreeView    *view,
 }
 
 static void
-job_finished_callback (EvJobAnnots          *job,
-		       EvSidebarAnnotations *sidebar_annots)
+ev_sidebar_annotations_show_model (EvSidebarAnnotations *sidebar_annots)
 {
-	EvSidebarAnnotationsPrivate *priv;
-	GtkTreeStore *model;
+	EvSidebarAnnotationsPrivate *priv = sidebar_annots->priv;
 	GtkTreeSelection *selection;
-	GList *l;
-
-	priv = sidebar_annots->priv;
-
-	if (!job->annots) {
-		GtkTreeModel *list;
-
-		list = ev_sidebar_annotations_create_simple_model (_("Document contains no annotations"));
-		gtk_tree_view_set_model (GTK_TREE_VIEW (priv->tree_view), list);
-		g_object_unref (list);
-
-		g_object_unref (job);
-		priv->job = NULL;
-
-		return;
-	}
 
 	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->tree_view));
 	gtk_tree_selection_set_mode (selection, GTK_SELECTION_SINGLE);
@@ -383,18 +373,36 @@ job_finished_callback (EvJobAnnots          *job,
                       G_CALLBACK (sidebar_tree_button_press_cb),
                       sidebar_annots);
 
+	gtk_tree_view_set_model (GTK_TREE_VIEW (priv->tree_view),
+				 GTK_TREE_MODEL (priv->model));
+}
 
-	model = gtk_tree_store_new (N_COLUMNS,
-				    G_TYPE_STRING,
-				    G_TYPE_STRING,
-				    G_TYPE_POINTER,
-				    G_TYPE_STRING);
+/* Appends the pages in @annots to the model being loaded, the model is
+ * shown as soon as it contains the first annotation.
+ */
+static void
+ev_sidebar_annotations_add_annots (EvSidebarAnnotations *sidebar_annots,
+				   GList                *annots)
+{
+	EvSidebarAnnotationsPrivate *priv = sidebar_annots->priv;
+	GtkTreeStore *model;
+	GList *l;
 
-	for (l = job->annots; l; l = g_list_next (l)) {
+	if (!priv->model) {
+		priv->model = gtk_tree_store_new (N_COLUMNS,
+						  G_TYPE_STRING,
+						  G_TYPE_STRING,
+						  G_TYPE_POINTER,
+						  G_TYPE_STRING);
+	}
+	model = priv->model;
+
+	for (l = annots; l; l = g_list_next (l)) {
 		EvMappingList *mapping_list;
 		GList         *ll;
 		gchar         *page_label;
 		GtkTreeIter    iter;
+		GtkTreePath   *path;
 		gboolean       found = FALSE;
 
 		mapping_list = (EvMappingList *)l->data;
@@ -470,15 +478,52 @@ job_finished_callback (EvJobAnnots          *job,
 			found = TRUE;
 		}
 
-		if (!found)
+		if (!found) {
 			gtk_tree_store_remove (model, &iter);
+			continue;
+		}
+
+		if (gtk_tree_view_get_model (GTK_TREE_VIEW (priv->tree_view)) != GTK_TREE_MODEL (model))
+			ev_sidebar_annotations_show_model (sidebar_annots);
+
+		path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), &iter);
+		gtk_tree_view_expand_row (GTK_TREE_VIEW (priv->tree_view), path, FALSE);
+		gtk_tree_path_free (path);
 	}
+}
 
-	gtk_tree_view_set_model (GTK_TREE_VIEW (priv->tree_view),
-				 GTK_TREE_MODEL (model));
-	gtk_tree_view_expand_all (GTK_TREE_VIEW (priv->tree_view));
-	g_object_unref (model);
+static void
+job_updated_callback (EvJobAnnots          *job,
+		      EvSidebarAnnotations *sidebar_annots)
+{
+	GList *new_annots;
+
+	new_annots = ev_job_annots_take_new_annots (job);
+	ev_sidebar_annotations_add_annots (sidebar_annots, new_annots);
+	g_list_free_full (new_annots, (GDestroyNotify) ev_mapping_list_unref);
+}
 
+static void
+job_finished_callback (EvJobAnnots          *job,
+		       EvSidebarAnnotations *sidebar_annots)
+{
+	EvSidebarAnnotationsPrivate *priv;
+
+	priv = sidebar_annots->priv;
+
+	/* Annotations found after the last update */
+	job_updated_callback (job, sidebar_annots);
+
+	if (!priv->model || !gtk_tree_model_iter_n_children (GTK_TREE_MODEL (priv->model), NULL)) {
+		GtkTreeModel *list;
+
+		list = ev_sidebar_annotations_create_simple_model (_("Document contains no annotations"));
+		gtk_tree_view_set_model (GTK_TREE_VIEW (priv->tree_view), list);
+		g_object_unref (list);
+	}
+
+	g_clear_object (&priv->model);
+	g_signal_handlers_disconnect_by_data (job, sidebar_annots);
 	g_object_unref (job);
 	priv->job = NULL;
 }
@@ -489,13 +534,16 @@ ev_sidebar_annotations_load (EvSidebarAnnotations *sidebar_annots)
 	EvSidebarAnnotationsPrivate *priv = sidebar_annots->priv;
 
 	if (priv->job) {
-		g_signal_handlers_disconnect_by_func (priv->job,
-						      job_finished_callback,
-						      sidebar_annots);
+		g_signal_handlers_disconnect_by_data (priv->job, sidebar_annots);
+		ev_job_cancel (priv->job);
 		g_object_unref (priv->job);
 	}
+	g_clear_object (&priv->model);
 
 	priv->job = ev_job_annots_new (priv->document);
+	g_signal_connect (priv->job, "updated",
+			  G_CALLBACK (job_updated_callback),
+			  sidebar_annots);
 	g_signal_connect (priv->job, "finished",
 			  G_CALLBACK (job_finished_callback),
 			  sidebar_annots);
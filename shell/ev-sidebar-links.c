@@ -72,7 +72,8 @@ static void row_activated_callback 			(GtkTreeView *treeview,
 	                                                 GtkTreeViewColumn *arg2,
 		                                         gpointer user_data);
 static void ev_sidebar_links_set_links_model            (EvSidebarLinks *links,
-							 GtkTreeModel   *model);
+							 GtkTreeModel   *model,
+							 GTree          *page_link_tree);
 static void job_finished_callback 			(EvJobLinks     *job,
 				    		         EvSidebarLinks *sidebar_links);
 static void ev_sidebar_links_set_current_page           (EvSidebarLinks *sidebar_links,
@@ -114,7 +115,7 @@ ev_sidebar_links_set_property (GObject      *object,
 	switch (prop_id)
 	{
 	case PROP_MODEL:
-		ev_sidebar_links_set_links_model (ev_sidebar_links, g_value_get_object (value));
+		ev_sidebar_links_set_links_model (ev_sidebar_links, g_value_get_object (value), NULL);
 		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1281,9 +1282,13 @@ update_page_link_tree_foreach (GtkTreeModel *model,
 	return FALSE;
 }
 
+/* @page_link_tree is the index of the first link per page built by
+ * the links job, when it's not given it's built here from @model.
+ */
 static void
 ev_sidebar_links_set_links_model (EvSidebarLinks *sidebar_links,
-				  GtkTreeModel   *model)
+				  GtkTreeModel   *model,
+				  GTree          *page_link_tree)
 {
 	EvSidebarLinksPrivate *priv = sidebar_links->priv;
 
@@ -1297,11 +1302,15 @@ ev_sidebar_links_set_links_model (EvSidebarLinks *sidebar_links,
 	/* Rebuild the binary search tree for finding links on pages. */
 	if (priv->page_link_tree)
 		g_tree_unref (priv->page_link_tree);
-	priv->page_link_tree = g_tree_new_full (page_link_tree_sort, NULL, NULL, (GDestroyNotify) gtk_tree_path_free);
 
-	gtk_tree_model_foreach (model,
-				update_page_link_tree_foreach,
-				sidebar_links);
+	if (page_link_tree) {
+		priv->page_link_tree = g_tree_ref (page_link_tree);
+	} else {
+		priv->page_link_tree = g_tree_new_full (page_link_tree_sort, NULL, NULL, (GDestroyNotify) gtk_tree_path_free);
+		gtk_tree_model_foreach (model,
+					update_page_link_tree_foreach,
+					sidebar_links);
+	}
 
 	g_object_notify (G_OBJECT (sidebar_links), "model");
 }
@@ -1317,7 +1326,8 @@ job_finished_callback (EvJobLinks     *job,
 	gchar *index_expand = NULL;
 	gchar *index_collapse = NULL;
 
-	ev_sidebar_links_set_links_model (sidebar_links, job->model);
+	ev_sidebar_links_set_links_model (sidebar_links, job->model,
+					  ev_job_links_get_page_link_tree (job));
 
 	gtk_tree_view_set_model (GTK_TREE_VIEW (priv->tree_view), job->model);
 	
@@ -44,6 +44,9 @@
 
 #define THUMBNAIL_WIDTH 100
 
+/* Maximum size of the rendered thumbnails kept outside the visible range */
+#define THUMBNAILS_CACHE_SIZE (16 * 1024 * 1024)
+
 typedef struct _EvThumbsSize
 {
 	gint width;
@@ -54,6 +57,7 @@ typedef struct _EvThumbsSizeCache {
 	gboolean uniform;
 	gint uniform_width;
 	gint uniform_height;
+	EvDocument *document;
 	EvThumbsSize *sizes;
 } EvThumbsSizeCache;
 
@@ -76,6 +80,10 @@ struct _EvSidebarThumbnailsPrivate {
 					 * for dual mode with !odd_left preference. Issue #30 */
 	/* Visible pages */
 	gint start_page, end_page;
+
+	/* Pages with a rendered thumbnail, least recently rendered first */
+	GQueue thumbnails;
+	gsize thumbnails_size;
 };
 
 enum {
@@ -136,8 +144,7 @@ static EvThumbsSizeCache *
 ev_thumbnails_size_cache_new (EvDocument *document)
 {
 	EvThumbsSizeCache *cache;
-	gint               i, n_pages;
-	EvThumbsSize      *thumb_size;
+	gint               n_pages;
 
 	cache = g_new0 (EvThumbsSizeCache, 1);
 
@@ -149,16 +156,13 @@ ev_thumbnails_size_cache_new (EvDocument *document)
 		return cache;
 	}
 
+	/* Sizes are computed the first time each page is asked for,
+	 * the cache is attached to the document so it can't outlive it.
+	 */
 	n_pages = ev_document_get_n_pages (document);
+	cache->document = document;
 	cache->sizes = g_new0 (EvThumbsSize, n_pages);
 
-	for (i = 0; i < n_pages; i++) {
-		thumb_size = &(cache->sizes[i]);
-		get_thumbnail_size_for_page (document, i,
-					     &thumb_size->width,
-					     &thumb_size->height);
-	}
-
 	return cache;
 }
 
@@ -178,6 +182,10 @@ ev_thumbnails_size_cache_get_size (EvThumbsSizeCache *cache,
 		EvThumbsSize *thumb_size;
 
 		thumb_size = &(cache->sizes[page]);
+		if (thumb_size->width == 0)
+			get_thumbnail_size_for_page (cache->document, page,
+						     &thumb_size->width,
+						     &thumb_size->height);
 
 		w = thumb_size->width;
 		h = thumb_size->height;
@@ -268,6 +276,8 @@ ev_sidebar_thumbnails_dispose (GObject *object)
 		sidebar_thumbnails->priv->list_store = NULL;
 	}
 
+	g_clear_object (&sidebar_thumbnails->priv->document);
+
 	G_OBJECT_CLASS (ev_sidebar_thumbnails_parent_class)->dispose (object);
 }
 
@@ -513,8 +523,18 @@ add_range (EvSidebarThumbnails *sidebar_thumbnails,
 
 		if (job == NULL && !thumbnail_set) {
 			gint thumbnail_width, thumbnail_height;
+			gint width, height;
+
 			get_size_for_page (sidebar_thumbnails, page, &thumbnail_width, &thumbnail_height);
 
+			/* The model is filled with the loading icon of the
+			 * first page, rows get the one for their own size
+			 * when they are about to be shown.
+			 */
+			ev_thumbnails_size_cache_get_size (priv->size_cache, page,
+							   priv->rotation,
+							   &width, &height);
+
 			job = ev_job_thumbnail_new_with_target_size (priv->document,
 								     page, priv->rotation,
 								     thumbnail_width, thumbnail_height);
@@ -527,6 +547,8 @@ add_range (EvSidebarThumbnails *sidebar_thumbnails,
 					  G_CALLBACK (thumbnail_job_completed_callback),
 					  sidebar_thumbnails);
 			gtk_list_store_set (priv->list_store, &iter,
+					    COLUMN_SURFACE, ev_sidebar_thumbnails_get_loading_icon (sidebar_thumbnails,
+												    width, height),
 					    COLUMN_JOB, job,
 					    -1);
 			ev_job_scheduler_push_job (EV_JOB (job), EV_JOB_PRIORITY_HIGH);
@@ -540,6 +562,62 @@ add_range (EvSidebarThumbnails *sidebar_thumbnails,
 	gtk_tree_path_free (path);
 }
 
+static gsize
+get_thumbnail_surface_size (cairo_surface_t *surface)
+{
+	return cairo_image_surface_get_stride (surface) *
+		cairo_image_surface_get_height (surface);
+}
+
+/* Puts the loading icon back for the least recently rendered thumbnails
+ * outside the preloaded range until they fit in THUMBNAILS_CACHE_SIZE,
+ * so scrolling through a huge document doesn't keep them all in memory.
+ */
+static void
+evict_thumbnails (EvSidebarThumbnails *sidebar_thumbnails)
+{
+	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
+	GList *l, *next;
+
+	for (l = priv->thumbnails.head; l && priv->thumbnails_size > THUMBNAILS_CACHE_SIZE; l = next) {
+		gint             page = GPOINTER_TO_INT (l->data);
+		gint             row = priv->blank_first_dual_mode ? page + 1 : page;
+		GtkTreePath     *path;
+		GtkTreeIter      iter;
+		cairo_surface_t *surface = NULL;
+		gint             width, height;
+
+		next = l->next;
+
+		if (row >= priv->start_page && row <= priv->end_page)
+			continue;
+
+		g_queue_delete_link (&priv->thumbnails, l);
+
+		path = gtk_tree_path_new_from_indices (row, -1);
+		if (gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->list_store), &iter, path)) {
+			gtk_tree_model_get (GTK_TREE_MODEL (priv->list_store), &iter,
+					    COLUMN_SURFACE, &surface,
+					    -1);
+			if (surface) {
+				priv->thumbnails_size -= MIN (priv->thumbnails_size,
+							      get_thumbnail_surface_size (surface));
+				cairo_surface_destroy (surface);
+			}
+
+			ev_thumbnails_size_cache_get_size (priv->size_cache, page,
+							   priv->rotation,
+							   &width, &height);
+			gtk_list_store_set (priv->list_store, &iter,
+					    COLUMN_SURFACE, ev_sidebar_thumbnails_get_loading_icon (sidebar_thumbnails,
+												    width, height),
+					    COLUMN_THUMBNAIL_SET, FALSE,
+					    -1);
+		}
+		gtk_tree_path_free (path);
+	}
+}
+
 /* This modifies start */
 static void
 update_visible_range (EvSidebarThumbnails *sidebar_thumbnails,
@@ -575,6 +653,8 @@ update_visible_range (EvSidebarThumbnails *sidebar_thumbnails,
 	
 	priv->start_page = start_page;
 	priv->end_page = end_page;
+
+	evict_thumbnails (sidebar_thumbnails);
 }
 
 static void
@@ -619,38 +699,45 @@ ev_sidebar_thumbnails_fill_model (EvSidebarThumbnails *sidebar_thumbnails)
 	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
 	GtkTreeIter iter;
 	int i;
-	gint prev_width = -1;
-	gint prev_height = -1;
+	gint width, height;
+	cairo_surface_t *loading_icon;
+
+	/* Detach the model while filling it, GtkIconView handles every
+	 * inserted row in linear time, which is quadratic for the whole
+	 * document.
+	 */
+	if (priv->icon_view)
+		gtk_icon_view_set_model (GTK_ICON_VIEW (priv->icon_view), NULL);
+
+	/* Getting the size of every page can mean asking the backend for
+	 * all of them, so rows start with the size of the first page and
+	 * add_range() sets the right one for the rows about to be shown.
+	 */
+	ev_thumbnails_size_cache_get_size (priv->size_cache, 0,
+					   priv->rotation,
+					   &width, &height);
+	loading_icon = ev_sidebar_thumbnails_get_loading_icon (sidebar_thumbnails,
+							       width, height);
 
 	for (i = 0; i < sidebar_thumbnails->priv->n_pages; i++) {
 		gchar     *page_label;
 		gchar     *page_string;
-		cairo_surface_t *loading_icon = NULL;
-		gint       width, height;
 
 		page_label = ev_document_get_page_label (priv->document, i);
 		page_string = g_markup_printf_escaped ("<i>%s</i>", page_label);
-		ev_thumbnails_size_cache_get_size (sidebar_thumbnails->priv->size_cache, i,
-						  sidebar_thumbnails->priv->rotation,
-						  &width, &height);
-		if (!loading_icon || (width != prev_width && height != prev_height)) {
-			loading_icon =
-				ev_sidebar_thumbnails_get_loading_icon (sidebar_thumbnails,
-									width, height);
-		}
 
-		prev_width = width;
-		prev_height = height;
-		
-		gtk_list_store_append (priv->list_store, &iter);
-		gtk_list_store_set (priv->list_store, &iter,
-				    COLUMN_PAGE_STRING, page_string,
-				    COLUMN_SURFACE, loading_icon,
-				    COLUMN_THUMBNAIL_SET, FALSE,
-				    -1);
+		gtk_list_store_insert_with_values (priv->list_store, &iter, i,
+						   COLUMN_PAGE_STRING, page_string,
+						   COLUMN_SURFACE, loading_icon,
+						   COLUMN_THUMBNAIL_SET, FALSE,
+						   -1);
 		g_free (page_label);
 		g_free (page_string);
 	}
+
+	if (priv->icon_view)
+		gtk_icon_view_set_model (GTK_ICON_VIEW (priv->icon_view),
+					 GTK_TREE_MODEL (priv->list_store));
 }
 
 static void
@@ -920,6 +1007,8 @@ thumbnail_job_completed_callback (EvJobThumbnail      *job,
 	iter = (GtkTreeIter *) g_object_get_data (G_OBJECT (job), "tree_iter");
 	if (priv->inverted_colors)
 		ev_document_misc_invert_surface (surface);
+	g_queue_push_tail (&priv->thumbnails, GINT_TO_POINTER (job->page));
+	priv->thumbnails_size += get_thumbnail_surface_size (surface);
 	gtk_list_store_set (priv->list_store,
 			    iter,
 			    COLUMN_SURFACE, surface,
@@ -931,6 +1020,57 @@ thumbnail_job_completed_callback (EvJobThumbnail      *job,
 	gtk_widget_queue_draw (priv->icon_view);
 }
 
+/* Collects the rendered thumbnails of the current document that are
+ * still valid for @document. Their pages are added to @pages, least
+ * recently rendered first, and their surfaces are returned indexed by
+ * page.
+ */
+static cairo_surface_t **
+ev_sidebar_thumbnails_get_unchanged (EvSidebarThumbnails *sidebar_thumbnails,
+				     EvDocument          *document,
+				     GQueue              *pages)
+{
+	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
+	cairo_surface_t **surfaces = NULL;
+	gint n_pages = ev_document_get_n_pages (document);
+	GList *l;
+
+	if (!priv->document ||
+	    priv->rotation != ev_document_model_get_rotation (priv->model) ||
+	    priv->inverted_colors != ev_document_model_get_inverted_colors (priv->model))
+		return NULL;
+
+	for (l = priv->thumbnails.head; l; l = g_list_next (l)) {
+		gint         page = GPOINTER_TO_INT (l->data);
+		gint         row = priv->blank_first_dual_mode ? page + 1 : page;
+		gchar       *old_fingerprint;
+		gchar       *new_fingerprint = NULL;
+		GtkTreeIter  iter;
+
+		if (page >= n_pages)
+			continue;
+
+		old_fingerprint = ev_document_get_page_fingerprint (priv->document, page);
+		if (old_fingerprint)
+			new_fingerprint = ev_document_get_page_fingerprint (document, page);
+
+		if (old_fingerprint && g_strcmp0 (old_fingerprint, new_fingerprint) == 0 &&
+		    gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (priv->list_store), &iter, NULL, row)) {
+			if (!surfaces)
+				surfaces = g_new0 (cairo_surface_t *, n_pages);
+			gtk_tree_model_get (GTK_TREE_MODEL (priv->list_store), &iter,
+					    COLUMN_SURFACE, &surfaces[page],
+					    -1);
+			g_queue_push_tail (pages, GINT_TO_POINTER (page));
+		}
+
+		g_free (old_fingerprint);
+		g_free (new_fingerprint);
+	}
+
+	return surfaces;
+}
+
 static void
 ev_sidebar_thumbnails_document_changed_cb (EvDocumentModel     *model,
 					   GParamSpec          *pspec,
@@ -938,14 +1078,23 @@ ev_sidebar_thumbnails_document_changed_cb (EvDocumentModel     *model,
 {
 	EvDocument *document = ev_document_model_get_document (model);
 	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
+	cairo_surface_t **unchanged;
+	GQueue unchanged_pages = G_QUEUE_INIT;
+	GList *l;
 
 	if (ev_document_get_n_pages (document) <= 0 ||
 	    !ev_document_check_dimensions (document)) {
 		return;
 	}
 
+	/* When the document is reloaded, keep the thumbnails of the pages
+	 * that didn't change.
+	 */
+	unchanged = ev_sidebar_thumbnails_get_unchanged (sidebar_thumbnails, document,
+							 &unchanged_pages);
+
 	priv->size_cache = ev_thumbnails_size_cache_get (document);
-	priv->document = document;
+	g_set_object (&priv->document, document);
 	priv->n_pages = ev_document_get_n_pages (document);
 	priv->rotation = ev_document_model_get_rotation (model);
 	priv->inverted_colors = ev_document_model_get_inverted_colors (model);
@@ -961,6 +1110,24 @@ ev_sidebar_thumbnails_document_changed_cb (EvDocumentModel     *model,
 	ev_sidebar_thumbnails_clear_model (sidebar_thumbnails);
 	ev_sidebar_thumbnails_fill_model (sidebar_thumbnails);
 
+	for (l = unchanged_pages.head; l; l = g_list_next (l)) {
+		gint             page = GPOINTER_TO_INT (l->data);
+		gint             row = priv->blank_first_dual_mode ? page + 1 : page;
+		cairo_surface_t *surface = unchanged[page];
+		GtkTreeIter      iter;
+
+		gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (priv->list_store), &iter, NULL, row);
+		gtk_list_store_set (priv->list_store, &iter,
+				    COLUMN_SURFACE, surface,
+				    COLUMN_THUMBNAIL_SET, TRUE,
+				    -1);
+		g_queue_push_tail (&priv->thumbnails, GINT_TO_POINTER (page));
+		priv->thumbnails_size += get_thumbnail_surface_size (surface);
+		cairo_surface_destroy (surface);
+	}
+	g_queue_clear (&unchanged_pages);
+	g_free (unchanged);
+
 	if (! priv->icon_view) {
 		ev_sidebar_init_icon_view (sidebar_thumbnails);
 		g_object_notify (G_OBJECT (sidebar_thumbnails), "main_widget");
@@ -1029,7 +1196,14 @@ ev_sidebar_thumbnails_clear_model (EvSidebarThumbnails *sidebar_thumbnails)
 	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
 	
 	gtk_tree_model_foreach (GTK_TREE_MODEL (priv->list_store), ev_sidebar_thumbnails_clear_job, sidebar_thumbnails);
+
+	/* See ev_sidebar_thumbnails_fill_model(), which attaches it again */
+	if (priv->icon_view)
+		gtk_icon_view_set_model (GTK_ICON_VIEW (priv->icon_view), NULL);
 	gtk_list_store_clear (priv->list_store);
+
+	g_queue_clear (&priv->thumbnails);
+	priv->thumbnails_size = 0;
 }
 
 static gboolean
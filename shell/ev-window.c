@@ -56,6 +56,7 @@
 #include "ev-document-misc.h"
 #include "ev-file-exporter.h"
 #include "ev-file-helpers.h"
+#include "ev-document-registry.h"
 #include "ev-file-monitor.h"
 #include "ev-history.h"
 #include "ev-image.h"
@@ -193,6 +194,7 @@ typedef struct {
 	EvDocumentModel *model;
 	char *uri;
 	gint64 uri_mtime;
+	gint64 document_mtime; /* of local files, when the load started */
 	char *local_uri;
 	char *display_name;
 	char *edit_name;
@@ -1906,6 +1908,47 @@ ev_window_handle_link (EvWindow *ev_window,
  * priv->password_{uri,document}, and thus people who call this
  * function should _not_ necessarily expect those to exist after being
  * called. */
+static void
+ev_window_setup_loaded_document (EvWindow   *ev_window,
+				 EvDocument *document)
+{
+	EvWindowPrivate *priv = GET_PRIVATE (ev_window);
+
+	ev_document_model_set_document (priv->model, document);
+
+#ifdef ENABLE_DBUS
+	ev_window_emit_doc_loaded (ev_window);
+#endif
+	setup_chrome_from_metadata (ev_window);
+	setup_document_from_metadata (ev_window);
+	setup_view_from_metadata (ev_window);
+
+	ev_window_add_recent (ev_window, priv->uri);
+
+	ev_window_title_set_type (priv->title,
+				  EV_WINDOW_TITLE_DOCUMENT);
+
+	ev_window_handle_link (ev_window, priv->dest);
+	g_clear_object (&priv->dest);
+
+	switch (priv->window_mode) {
+	        case EV_WINDOW_MODE_FULLSCREEN:
+			ev_window_run_fullscreen (ev_window);
+			break;
+	        case EV_WINDOW_MODE_PRESENTATION:
+			ev_window_run_presentation (ev_window);
+			break;
+	        default:
+			break;
+	}
+
+	/* Create a monitor for the document */
+	priv->monitor = ev_file_monitor_new (priv->uri);
+	g_signal_connect_swapped (priv->monitor, "changed",
+				  G_CALLBACK (ev_window_file_changed),
+				  ev_window);
+}
+
 static void
 ev_window_load_job_cb (EvJob *job,
 		       gpointer data)
@@ -1923,19 +1966,6 @@ ev_window_load_job_cb (EvJob *job,
 
 	/* Success! */
 	if (!ev_job_is_failed (job)) {
-		ev_document_model_set_document (priv->model, document);
-
-#ifdef ENABLE_DBUS
-		ev_window_emit_doc_loaded (ev_window);
-#endif
-		setup_chrome_from_metadata (ev_window);
-		setup_document_from_metadata (ev_window);
-		setup_view_from_metadata (ev_window);
-
-		ev_window_add_recent (ev_window, priv->uri);
-
-		ev_window_title_set_type (priv->title,
-					  EV_WINDOW_TITLE_DOCUMENT);
 		if (job_load->password) {
 			GPasswordSave flags;
 
@@ -1946,26 +1976,11 @@ ev_window_load_job_cb (EvJob *job,
 						  flags);
 		}
 
-		ev_window_handle_link (ev_window, priv->dest);
-		g_clear_object (&priv->dest);
+		ev_window_setup_loaded_document (ev_window, document);
 
-		switch (priv->window_mode) {
-		        case EV_WINDOW_MODE_FULLSCREEN:
-				ev_window_run_fullscreen (ev_window);
-				break;
-		        case EV_WINDOW_MODE_PRESENTATION:
-				ev_window_run_presentation (ev_window);
-				break;
-		        default:
-				break;
-		}
+		if (!priv->local_uri)
+			ev_document_registry_add (priv->uri, priv->document_mtime, document);
 
-		/* Create a monitor for the document */
-		priv->monitor = ev_file_monitor_new (priv->uri);
-		g_signal_connect_swapped (priv->monitor, "changed",
-					  G_CALLBACK (ev_window_file_changed),
-					  ev_window);
-		
 		ev_window_clear_load_job (ev_window);
 		return;
 	}
@@ -2020,6 +2035,23 @@ ev_window_load_job_cb (EvJob *job,
 	}	
 }
 
+static void
+ev_window_setup_reloaded_document (EvWindow   *ev_window,
+				   EvDocument *document)
+{
+	EvWindowPrivate *priv = GET_PRIVATE (ev_window);
+
+	ev_document_model_set_document (priv->model, document);
+	if (priv->dest) {
+		ev_window_handle_link (ev_window, priv->dest);
+		g_clear_object (&priv->dest);
+	}
+
+	/* Restart the search after reloading */
+	if (gtk_search_bar_get_search_mode (GTK_SEARCH_BAR (priv->search_bar)))
+		ev_search_box_restart (EV_SEARCH_BOX (priv->search_box));
+}
+
 static void
 ev_window_reload_job_cb (EvJob    *job,
 			 EvWindow *ev_window)
@@ -2037,16 +2069,10 @@ ev_window_reload_job_cb (EvJob    *job,
 		return;
 	}
 
-	ev_document_model_set_document (priv->model,
-					job->document);
-	if (priv->dest) {
-		ev_window_handle_link (ev_window, priv->dest);
-		g_clear_object (&priv->dest);
-	}
+	ev_window_setup_reloaded_document (ev_window, job->document);
 
-	/* Restart the search after reloading */
-	if (gtk_search_bar_get_search_mode (GTK_SEARCH_BAR (priv->search_bar)))
-		ev_search_box_restart (EV_SEARCH_BOX (priv->search_box));
+	if (!priv->local_uri)
+		ev_document_registry_add (priv->uri, priv->document_mtime, job->document);
 
 	ev_window_clear_reload_job (ev_window);
 	priv->in_reload = FALSE;
@@ -2418,6 +2444,7 @@ ev_window_open_uri (EvWindow       *ev_window,
 		    const gchar    *search_string)
 {
 	EvWindowPrivate *priv = GET_PRIVATE (ev_window);
+	EvDocument *document;
 	GFile *source_file;
 
 	priv->in_reload = FALSE;
@@ -2483,6 +2510,18 @@ ev_window_open_uri (EvWindow       *ev_window,
 	setup_size_from_metadata (ev_window);
 	setup_model_from_metadata (ev_window);
 
+	/* Share the document if another window has already loaded the
+	 * current version of the file.
+	 */
+	priv->document_mtime = ev_document_registry_get_mtime (uri);
+	document = ev_document_registry_lookup (uri, priv->document_mtime);
+	if (document) {
+		ev_window_setup_loaded_document (ev_window, document);
+		g_object_unref (document);
+		g_object_unref (source_file);
+		return;
+	}
+
 	priv->load_job = ev_job_load_new (uri);
 	g_signal_connect (priv->load_job,
 			  "finished",
@@ -2616,6 +2655,25 @@ ev_window_reload_local (EvWindow *ev_window)
 	const gchar *uri;
 
 	uri = priv->local_uri ? priv->local_uri : priv->uri;
+
+	if (!priv->local_uri) {
+		EvDocument *document;
+
+		/* Reloading the document of this window must always read
+		 * the file again, but the file may have already been
+		 * reloaded by another window.
+		 */
+		priv->document_mtime = ev_document_registry_get_mtime (uri);
+		document = ev_document_registry_lookup (uri, priv->document_mtime);
+		if (document && document != priv->document) {
+			ev_window_setup_reloaded_document (ev_window, document);
+			g_object_unref (document);
+			priv->in_reload = FALSE;
+			return;
+		}
+		g_clear_object (&document);
+	}
+
 	priv->reload_job = ev_job_load_new (uri);
 	g_signal_connect (priv->reload_job, "finished",
 			  G_CALLBACK (ev_window_reload_job_cb),
@@ -4723,6 +4781,9 @@ ev_window_run_presentation (EvWindow *window)
 								    current_page,
 								    rotation,
 								    inverted_colors);
+	ev_view_presentation_set_cache_size (EV_VIEW_PRESENTATION (priv->presentation_view),
+					     (gsize) g_settings_get_uint (ev_window_ensure_settings (window),
+									  GS_PAGE_CACHE_SIZE) * 1024 * 1024);
 	g_signal_connect_swapped (priv->presentation_view, "finished",
 				  G_CALLBACK (ev_window_view_presentation_finished),
 				  window);
@@ -43,10 +43,15 @@ static gboolean finished = TRUE;
 static gint size = THUMBNAIL_SIZE;
 static gboolean time_limit = TRUE;
 static const gchar **file_arguments;
+static gchar *batch_file = NULL;
+static gint n_jobs = 0;
+static GMutex batch_mutex;
 
 static const GOptionEntry goption_options[] = {
 	{ "size", 's', 0, G_OPTION_ARG_INT, &size, NULL, "SIZE" },
         { "no-limit", 'l', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &time_limit, "Don't limit the thumbnailing time to 15 seconds", NULL },
+	{ "batch", 'b', 0, G_OPTION_ARG_FILENAME, &batch_file, "Read “input<TAB>output[<TAB>size]” lines from FILE, or from stdin if FILE is “-”", "FILE" },
+	{ "jobs", 'j', 0, G_OPTION_ARG_INT, &n_jobs, "Number of files to process in parallel in batch mode", "N" },
 	{ G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &file_arguments, NULL, "<input> <ouput>" },
 	{ NULL }
 };
@@ -126,8 +131,12 @@ get_local_path (GFile *file)
 	return g_file_get_path (file);
 }
 
+/* In batch mode, @load_start is set under batch_mutex to the time the
+ * document started loading, once the loads of other files are done.
+ */
 static EvDocument *
-evince_thumbnailer_get_document (GFile *file)
+evince_thumbnailer_get_document (GFile  *file,
+				 gint64 *load_start)
 {
 	EvDocument *document = NULL;
 	gchar      *uri, *path;
@@ -167,7 +176,14 @@ evince_thumbnailer_get_document (GFile *file)
 		g_free (path);
 	}
 
-	document = ev_document_factory_get_document_full (uri, EV_DOCUMENT_LOAD_FLAG_NO_CACHE, &error);
+	ev_document_fc_mutex_lock ();
+	if (load_start) {
+		g_mutex_lock (&batch_mutex);
+		*load_start = g_get_monotonic_time ();
+		g_mutex_unlock (&batch_mutex);
+	}
+	document = ev_document_factory_get_document_full (uri, EV_DOCUMENT_LOAD_FLAG_PROBE, &error);
+	ev_document_fc_mutex_unlock ();
 	if (tmp_file) {
 		if (document) {
 			g_object_weak_ref (G_OBJECT (document),
@@ -194,8 +210,9 @@ evince_thumbnailer_get_document (GFile *file)
 	return document;
 }
 
-static gboolean
-evince_thumbnail_pngenc_get (EvDocument *document, const char *thumbnail, int size)
+/* Must be called with the document mutex held */
+static GdkPixbuf *
+evince_thumbnail_render (EvDocument *document, int size)
 {
 	EvRenderContext *rc;
 	double width, height;
@@ -210,17 +227,31 @@ evince_thumbnail_pngenc_get (EvDocument *document, const char *thumbnail, int si
 	pixbuf = ev_document_get_thumbnail (document, rc);
 	g_object_unref (rc);
 	g_object_unref (page);
-	
-	if (pixbuf != NULL) {
-		if (gdk_pixbuf_save (pixbuf, thumbnail, "png", NULL, NULL)) {
-			g_object_unref  (pixbuf);
-			return TRUE;
-		}
 
-		g_object_unref  (pixbuf);
-	}
-	
-	return FALSE;
+	return pixbuf;
+}
+
+static gboolean
+evince_thumbnail_save (GdkPixbuf *pixbuf, const char *thumbnail)
+{
+	gboolean success;
+
+	if (pixbuf == NULL)
+		return FALSE;
+
+	/* Thumbnails are small and short lived, favour encoding speed */
+	success = gdk_pixbuf_save (pixbuf, thumbnail, "png", NULL,
+				   "compression", "1", NULL);
+	g_object_unref (pixbuf);
+
+	return success;
+}
+
+static gboolean
+evince_thumbnail_pngenc_get (EvDocument *document, const char *thumbnail, int size)
+{
+	return evince_thumbnail_save (evince_thumbnail_render (document, size),
+				      thumbnail);
 }
 
 static gpointer
@@ -237,6 +268,284 @@ evince_thumbnail_pngenc_get_async (struct AsyncData *data)
 	return NULL;
 }
 
+/* Batch mode: every line of the batch file describes a thumbnail to
+ * create. Files are processed by a pool of worker threads sharing the
+ * already loaded backends, and a status line is printed to stdout for
+ * every file as soon as it's done:
+ *
+ *   <status>\t<input>\t<output>\t<load time ms>\t<render time ms>
+ *
+ * where status is one of "ok", "failed" or "timeout".
+ */
+typedef struct {
+	gchar  *input;
+	gchar  *output;
+	gint    size;
+	gint64  load_start;
+	gint64  load_time;
+	gint64  render_start;
+} BatchItem;
+
+static GPtrArray *batch_running = NULL;
+static gboolean   batch_finished = FALSE;
+static gboolean   batch_failed = FALSE;
+
+static void
+batch_item_free (BatchItem *item)
+{
+	g_free (item->input);
+	g_free (item->output);
+	g_free (item);
+}
+
+/* Must be called with batch_mutex held */
+static void
+batch_report (const gchar *status,
+	      BatchItem   *item,
+	      gint64       load_time,
+	      gint64       render_time)
+{
+	g_print ("%s\t%s\t%s\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\n",
+		 status, item->input, item->output,
+		 load_time / 1000, render_time / 1000);
+	fflush (stdout);
+}
+
+/* The load and the render are only timed once the factory and the
+ * document mutex are held, so that files waiting for other files to be
+ * loaded or rendered are not reported as timed out. The thumbnail is
+ * saved once the document mutex is released, so that other files can
+ * be rendered in the meantime.
+ */
+static void
+batch_process_item (BatchItem *item,
+		    gpointer   user_data)
+{
+	EvDocument *document = NULL;
+	GdkPixbuf  *pixbuf = NULL;
+	GFile      *file;
+	gint64      load_done, render_time = 0;
+	gboolean    success = FALSE;
+
+	g_mutex_lock (&batch_mutex);
+	g_ptr_array_add (batch_running, item);
+	g_mutex_unlock (&batch_mutex);
+
+	file = g_file_new_for_commandline_arg (item->input);
+	document = evince_thumbnailer_get_document (file, &item->load_start);
+	g_object_unref (file);
+
+	load_done = g_get_monotonic_time ();
+	g_mutex_lock (&batch_mutex);
+	item->load_time = item->load_start != 0 ? load_done - item->load_start : 0;
+	item->load_start = 0;
+	g_mutex_unlock (&batch_mutex);
+
+	if (document) {
+		ev_document_doc_mutex_lock ();
+
+		g_mutex_lock (&batch_mutex);
+		item->render_start = g_get_monotonic_time ();
+		g_mutex_unlock (&batch_mutex);
+
+		pixbuf = evince_thumbnail_render (document, item->size);
+
+		g_mutex_lock (&batch_mutex);
+		render_time = g_get_monotonic_time () - item->render_start;
+		item->render_start = 0;
+		g_mutex_unlock (&batch_mutex);
+
+		ev_document_doc_mutex_unlock ();
+		g_object_unref (document);
+
+		success = evince_thumbnail_save (pixbuf, item->output);
+	}
+
+	g_mutex_lock (&batch_mutex);
+	g_ptr_array_remove_fast (batch_running, item);
+	if (!success)
+		batch_failed = TRUE;
+	batch_report (success ? "ok" : "failed", item,
+		      item->load_time, render_time);
+	g_mutex_unlock (&batch_mutex);
+
+	batch_item_free (item);
+}
+
+/* Same idea as time_monitor, but checking the load and the render of
+ * every file being processed. A backend stuck on a file keeps the
+ * factory or the document mutex locked, so there's nothing else to do
+ * than reporting the files still running and exit, letting the caller
+ * resubmit the files that were not reported.
+ */
+G_GNUC_NORETURN static gpointer
+batch_time_monitor (gpointer data)
+{
+	while (TRUE) {
+		gint64   now;
+		gboolean timed_out = FALSE;
+		guint    i;
+
+		g_usleep (G_USEC_PER_SEC);
+
+		g_mutex_lock (&batch_mutex);
+		if (batch_finished) {
+			g_mutex_unlock (&batch_mutex);
+			g_thread_exit (NULL);
+		}
+
+		now = g_get_monotonic_time ();
+		for (i = 0; i < batch_running->len; i++) {
+			BatchItem *item = g_ptr_array_index (batch_running, i);
+
+			if ((item->load_start != 0 &&
+			     now - item->load_start > DEFAULT_SLEEP_TIME) ||
+			    (item->render_start != 0 &&
+			     now - item->render_start > DEFAULT_SLEEP_TIME)) {
+				timed_out = TRUE;
+				break;
+			}
+		}
+
+		if (timed_out) {
+			for (i = 0; i < batch_running->len; i++) {
+				BatchItem *item = g_ptr_array_index (batch_running, i);
+
+				batch_report ("timeout", item,
+					      item->load_start != 0 ? now - item->load_start : item->load_time,
+					      item->render_start != 0 ? now - item->render_start : 0);
+			}
+
+			exit (-2);
+		}
+		g_mutex_unlock (&batch_mutex);
+	}
+}
+
+static BatchItem *
+batch_item_new_from_line (const gchar *line,
+			  gint         default_size)
+{
+	BatchItem *item;
+	gchar    **fields;
+	gint       item_size = default_size;
+
+	fields = g_strsplit (line, "\t", 3);
+	if (g_strv_length (fields) < 2 || *fields[0] == '\0' || *fields[1] == '\0') {
+		g_printerr ("Invalid batch line: '%s'\n", line);
+		g_strfreev (fields);
+
+		return NULL;
+	}
+
+	if (fields[2]) {
+		gchar *endptr;
+
+		item_size = (gint) g_ascii_strtoll (fields[2], &endptr, 10);
+		if (*endptr != '\0' || item_size < 1) {
+			g_printerr ("Invalid size in batch line: '%s'\n", line);
+			g_strfreev (fields);
+
+			return NULL;
+		}
+	}
+
+	item = g_new0 (BatchItem, 1);
+	item->input = g_strdup (fields[0]);
+	item->output = g_strdup (fields[1]);
+	item->size = item_size;
+	g_strfreev (fields);
+
+	return item;
+}
+
+static gint
+evince_thumbnailer_run_batch (const gchar *filename,
+			      gint         default_size,
+			      gint         max_threads)
+{
+	GIOChannel  *channel;
+	GThreadPool *pool;
+	GThread     *monitor = NULL;
+	gchar       *line;
+	GIOStatus    status;
+	GError      *error = NULL;
+
+	if (g_strcmp0 (filename, "-") == 0) {
+#ifdef G_OS_WIN32
+		channel = g_io_channel_win32_new_fd (0);
+#else
+		channel = g_io_channel_unix_new (0);
+#endif
+	} else {
+		channel = g_io_channel_new_file (filename, "r", &error);
+		if (!channel) {
+			g_printerr ("Error opening batch file: %s\n", error->message);
+			g_error_free (error);
+
+			return -1;
+		}
+	}
+	/* File names are not necessarily UTF-8 */
+	g_io_channel_set_encoding (channel, NULL, NULL);
+
+	if (max_threads < 1)
+		max_threads = g_get_num_processors ();
+
+	batch_running = g_ptr_array_new ();
+	pool = g_thread_pool_new ((GFunc) batch_process_item, NULL,
+				  max_threads, FALSE, NULL);
+
+	if (time_limit)
+		monitor = g_thread_new ("ThumbnailerTimer", batch_time_monitor, NULL);
+
+	while ((status = g_io_channel_read_line (channel, &line, NULL, NULL, &error)) == G_IO_STATUS_NORMAL) {
+		BatchItem *item;
+
+		g_strchomp (line);
+		if (*line == '\0' || *line == '#') {
+			g_free (line);
+			continue;
+		}
+
+		item = batch_item_new_from_line (line, default_size);
+		g_free (line);
+		if (!item) {
+			g_mutex_lock (&batch_mutex);
+			batch_failed = TRUE;
+			g_mutex_unlock (&batch_mutex);
+			continue;
+		}
+
+		g_thread_pool_push (pool, item, NULL);
+	}
+
+	if (status == G_IO_STATUS_ERROR) {
+		g_printerr ("Error reading batch file: %s\n", error->message);
+		g_error_free (error);
+		g_mutex_lock (&batch_mutex);
+		batch_failed = TRUE;
+		g_mutex_unlock (&batch_mutex);
+	}
+
+	g_io_channel_unref (channel);
+
+	/* Wait for all the pending files */
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	g_mutex_lock (&batch_mutex);
+	batch_finished = TRUE;
+	g_mutex_unlock (&batch_mutex);
+
+	if (monitor)
+		g_thread_join (monitor);
+
+	g_ptr_array_free (batch_running, TRUE);
+	batch_running = NULL;
+
+	return batch_failed ? -2 : 0;
+}
+
 static void
 print_usage (GOptionContext *context)
 {
@@ -271,6 +580,26 @@ main (int argc, char *argv[])
 		return -1;
 	}
 
+	if (batch_file) {
+		gint retval;
+
+		g_option_context_free (context);
+
+		if (size < 1) {
+			g_printerr ("Size cannot be smaller than 1 pixel\n");
+			return -1;
+		}
+
+		if (!ev_init ())
+			return -1;
+
+		retval = evince_thumbnailer_run_batch (batch_file, size, n_jobs);
+		g_free (batch_file);
+		ev_shutdown ();
+
+		return retval;
+	}
+
 	input = file_arguments ? file_arguments[0] : NULL;
 	output = input ? file_arguments[1] : NULL;
 	if (!input || !output) {
@@ -294,7 +623,7 @@ main (int argc, char *argv[])
                 return -1;
 
 	file = g_file_new_for_commandline_arg (input);
-	document = evince_thumbnailer_get_document (file);
+	document = evince_thumbnailer_get_document (file, NULL);
 	g_object_unref (file);
 
 	if (!document) {